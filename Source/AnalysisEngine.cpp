@@ -0,0 +1,776 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "AnalysisEngine.h"
+
+
+AnalysisEngine::AnalysisEngine(){
+
+    windowSize = 2048*4; // maybe make this smaller or variable on sample rate or file size? or let user change?
+
+    onlineLookAheadBlocks = 32; // ~6 seconds at 44.1kHz, enough for the max distance to settle
+
+    progressStart = 0;
+    progressRange = 1;
+};
+
+AnalysisEngine::~AnalysisEngine(){
+};
+
+bool AnalysisEngine::calculateSimilarity(SegaudioFile* refFile, AudioRegion refRegion, SegaudioFile* targetFile, SignalFeaturesToUse* featuresToUse, ClusterParameters* onlineClusterParams, Array<float>* distanceArray, float* maxDistance){
+
+    distanceArray->clearQuick();
+    *maxDistance = 0;
+
+    // Step 1 and 2: features of the reference region, averaged
+    Eigen::RowVectorXf avgRegionFeatures = calculateReferenceFeatures(refFile, refRegion, featuresToUse);
+
+    if(isCalculationCancelled()) return false;
+
+    return calculateTargetSimilarity(avgRegionFeatures, targetFile, featuresToUse, onlineClusterParams, distanceArray, maxDistance);
+}
+
+Eigen::RowVectorXf AnalysisEngine::calculateReferenceFeatures(SegaudioFile* refFile, AudioRegion refRegion, SignalFeaturesToUse* featuresToUse){
+
+    Time testTime = Time(); // for debugging
+    int startTime  = testTime.getApproximateMillisecondCounter();
+
+    // Step 1: calculate feature matrix for reference region
+    setCalculationStatus("Calculating reference features...");
+    progressStart = 0.0; progressRange = 0.1;
+    refFeatureMat = calculateFeatureMatrix(refFile, featuresToUse, refRegion);
+    DBG("Finished reg features: " + String(testTime.getApproximateMillisecondCounter() - startTime));
+
+    //  Step 2: average values for all blocks in reference region
+    // TODO: handle if region is smaller than blocksize
+    // TODO: maybe use median instead of mean for this?
+    return refFeatureMat.colwise().mean(); // use the average of the reference region
+}
+
+bool AnalysisEngine::calculateTargetSimilarity(const Eigen::RowVectorXf &avgRegionFeatures, SegaudioFile* targetFile, SignalFeaturesToUse* featuresToUse, ClusterParameters* onlineClusterParams, Array<float>* distanceArray, float* maxDistance){
+
+    Time testTime = Time(); // for debugging
+    int startTime  = testTime.getApproximateMillisecondCounter();
+
+    distanceArray->clearQuick();
+    *maxDistance = 0;
+
+    // Step 3: calculate features and cosine distance for each block of target file, one block at a time so the
+    // online segmenter gets distances while the file is still being analysed
+    setCalculationStatus("Calculating target features...");
+    progressStart = 0.1; progressRange = 0.9;
+
+    int startBlock, endBlock;
+    getBlockRange(targetFile, AudioRegion(0, 1), &startBlock, &endBlock);
+    int numTargetBlocks = jmax(0, endBlock - startBlock); // one distance per block like before, the partial last block is padded with 0 so regions reach the end of the file
+
+    if(featuresToUse->isNoneSelected()){
+        numTargetBlocks = 0;
+    }
+
+    float maxDistanceVal = 0; // keep track of max for drawing, and void calculating it later
+    distanceArray->ensureStorageAllocated(numTargetBlocks);
+
+    if(onlineClusterParams != nullptr){
+        onlineSegmenter.reset(*onlineClusterParams, numTargetBlocks, onlineLookAheadBlocks);
+    }
+
+    Array<Range<int> > finishedBlockRanges;
+
+    for(int i=0; i<numTargetBlocks; i++){
+
+        if(isCalculationCancelled()){ // cancel button pressed, results are thrown away anyway
+            return false;
+        }
+
+        setBlockProgress(i + 1, numTargetBlocks);
+
+        Eigen::RowVectorXf blockFeatures = calculateBlockFeatures(targetFile, featuresToUse, startBlock + i);
+        float distanceVal = calculateDistance(blockFeatures, avgRegionFeatures);
+
+        if(distanceVal > maxDistanceVal){ // update max
+            maxDistanceVal = distanceVal;
+        }
+
+        distanceArray->add(distanceVal); // add to array
+
+        if(onlineClusterParams != nullptr){
+            onlineSegmenter.addDistance(distanceVal);
+            if(i == numTargetBlocks - 1){
+                onlineSegmenter.finish();
+            }
+
+            if(onlineSegmenter.takeFinishedRegions(&finishedBlockRanges) > 0){
+                {
+                    const ScopedLock sl(onlineRegionsLock);
+                    for(int j=0; j<finishedBlockRanges.size(); j++){
+                        onlineRegions.add(getRegionFromBlocks(finishedBlockRanges[j].getStart(), finishedBlockRanges[j].getEnd(), numTargetBlocks, targetFile));
+                    }
+                }
+                finishedBlockRanges.clearQuick();
+                onlineRegionsFound();
+            }
+        }
+    }
+    DBG("Finished target features: " + String(testTime.getApproximateMillisecondCounter() - startTime));
+
+    *maxDistance = maxDistanceVal;
+
+    setCalculationProgress(1.0);
+    return true;
+}
+
+bool AnalysisEngine::isCalculationCancelled(){
+    return false;
+}
+
+void AnalysisEngine::setCalculationProgress(double /*progress*/){
+}
+
+void AnalysisEngine::setCalculationStatus(const String &/*status*/){
+}
+
+void AnalysisEngine::onlineRegionsFound(){
+}
+
+void AnalysisEngine::setBlockProgress(int numProcessedBlocks, int numBlocksToProcess){
+    if(numBlocksToProcess > 0){
+        setCalculationProgress(progressStart + progressRange * double(numProcessedBlocks) / numBlocksToProcess);
+    }
+}
+
+int AnalysisEngine::takeOnlineRegions(Array<AudioRegion>* regions){
+
+    const ScopedLock sl(onlineRegionsLock);
+
+    int numRegions = onlineRegions.size();
+    regions->addArray(onlineRegions);
+    onlineRegions.clearQuick();
+
+    return numRegions;
+}
+
+void AnalysisEngine::getBlockRange(SegaudioFile* file, AudioRegion region, int* startBlock, int* endBlock){
+
+    int64 totalNumSamples = file->getNumSamples(); // block counts fit in int, sample positions don't
+    int approxNumBlocks = int(totalNumSamples / windowSize);
+    int numTotalBlocks;
+    if(int64(approxNumBlocks) * windowSize == totalNumSamples){  // handle likely partial block at end
+        numTotalBlocks = approxNumBlocks;
+    }
+    else{
+        numTotalBlocks = approxNumBlocks + 1;
+    }
+
+    // for reference, start and end are likely in middle of file
+    *startBlock = floor(region.getStart(numTotalBlocks));
+    *endBlock = floor(region.getEnd(numTotalBlocks));
+}
+
+Eigen::MatrixXf AnalysisEngine::calculateFeatureMatrix(SegaudioFile* file, SignalFeaturesToUse* featuresToUse, AudioRegion region){
+    
+    if(featuresToUse->isNoneSelected()){ // skip all this if no features selected and return empty matrix
+        Eigen::MatrixXf featureMatrix = Eigen::MatrixXf::Zero(0, 0);
+        return featureMatrix;
+    }
+    
+    // Separate into blocks
+    int startBlock, endBlock;
+    getBlockRange(file, region, &startBlock, &endBlock);
+
+    // initialize vars for feature matrix
+    int numBlocksToProcess = endBlock - startBlock;
+    int numFeaturesSelected = featuresToUse->getNumSelected();
+    Eigen::MatrixXf featureMatrix = Eigen::MatrixXf::Zero(numBlocksToProcess, numFeaturesSelected);
+    
+    //=== Process blocks
+    float rmsMean=0, rmsStd=0, zcrMean=0, zcrStd=0, scMean=0, scStd=0, mfccMean=0, mfccStd=0; // for running feature standardization
+    int rmsIdx=0, zcrIdx=0, scIdx=0, mfccIdx=0;
+    int numProcessedBlocks = 0;
+    int blockIdx = 0;
+    
+    for(int i=startBlock; i<endBlock-1; i++){
+
+        if(isCalculationCancelled()){ // cancel button pressed, results are thrown away anyway
+            break;
+        }
+
+        numProcessedBlocks += 1;
+        setBlockProgress(numProcessedBlocks, numBlocksToProcess);
+
+        featureMatrix.row(blockIdx) = calculateBlockFeatures(file, featuresToUse, i);
+        
+        blockIdx += 1; // keep track of where to put features in matrix
+    }
+
+    // So ignore this scaling stuff below for now. Tried feature scaling with standardization, but that made results
+    // a little worse. Maybe don't allow multiple features? Or scale 0-1 for now?
+    // Probably will need to remove some high outliers as these skew the similarity function making finding a
+    // proper threshold with a slider difficult
+
+//    Eigen::VectorXf meanArray;
+//
+    //=== Standardize features
+//    if(featuresToUse->rms){
+//        rmsMean = featureMatrix.col(rmsIdx).array().mean();
+//        meanArray = Eigen::VectorXf::Constant(numBlocksToProcess, 1, rmsMean);
+//        Eigen::VectorXf tmpArray = featureMatrix.col(rmsIdx) - meanArray;
+//        
+//        float tmp1 = tmpArray.array().pow(2).sum() / float(numBlocksToProcess);
+//        rmsStd = sqrt(tmp1);
+//        
+//        featureMatrix.col(rmsIdx) = (featureMatrix.col(rmsIdx) - Eigen::MatrixXf::Constant(numBlocksToProcess, 1, rmsMean)) / rmsStd;
+//    }
+//    
+//    if(featuresToUse->zcr){
+//        zcrMean = featureMatrix.col(zcrIdx).array().mean();
+//        meanArray = Eigen::VectorXf::Constant(numBlocksToProcess, 1, zcrMean);
+//        Eigen::VectorXf tmpArray = featureMatrix.col(zcrIdx) - meanArray;
+//        
+//        float tmp1 = tmpArray.array().pow(2).sum() / float(numBlocksToProcess);
+//        zcrStd = sqrt(tmp1);
+//
+//        featureMatrix.col(zcrIdx) = (featureMatrix.col(zcrIdx) - Eigen::MatrixXf::Constant(numBlocksToProcess, 1, zcrMean)) / zcrStd;
+//    }
+//    
+//    if(featuresToUse->sc){
+//        scMean = featureMatrix.col(scIdx).array().mean();
+//        meanArray = Eigen::VectorXf::Constant(numBlocksToProcess, 1, scMean);
+//        Eigen::VectorXf tmpArray = featureMatrix.col(scIdx) - meanArray;
+//        
+//        float tmp1 = tmpArray.array().pow(2).sum() / float(numBlocksToProcess);
+//        scStd = sqrt(tmp1);
+//        
+//        featureMatrix.col(scIdx) = (featureMatrix.col(scIdx) - Eigen::MatrixXf::Constant(numBlocksToProcess, 1, scMean)) / scStd;
+//    }
+    
+//    if(featuresToUse->mfcc){
+//        mfccMean = featureMatrix.col(scIdx).array().mean();
+//        meanArray = Eigen::VectorXf::Constant(numBlocksToProcess, 1, scMean);
+//        Eigen::VectorXf tmpArray = featureMatrix.col(scIdx) - meanArray;
+//        
+//        float tmp1 = tmpArray.array().pow(2).sum() / float(numBlocksToProcess);
+//        scStd = sqrt(tmp1);
+//        
+//        featureMatrix.col(scIdx) = (featureMatrix.col(scIdx) - Eigen::MatrixXf::Constant(numBlocksToProcess, 1, scMean)) / scStd;
+//    }
+    
+    return featureMatrix;
+}
+
+
+Eigen::RowVectorXf AnalysisEngine::calculateBlockFeatures(SegaudioFile* file, SignalFeaturesToUse* featuresToUse, int blockIdx){
+
+    Eigen::RowVectorXf blockFeatures = Eigen::RowVectorXf::Zero(featuresToUse->getNumSelected());
+    int featureIdx = 0; // for indexing feature vector w/variable num features
+
+    //---Read block of samples, only this window is touched for memory mapped files
+    int64 blockSampleIdx = int64(blockIdx) * windowSize; // sample idx of block, using windowSize as blockSize and fft size
+
+    AudioSampleBuffer asbBlock = AudioSampleBuffer(file->getNumChannels(), windowSize); // for time domain features
+    file->readSamples(&asbBlock, 0, blockSampleIdx, windowSize); // last block is padded with 0
+
+    // TODO: handle multiple channels here?
+
+    Eigen::Map<Eigen::RowVectorXf> mBlock(asbBlock.getSampleData(0), windowSize);
+    Eigen::FFT<float> fft;
+    Eigen::RowVectorXcf blockFft;
+
+    //---Calculate fft only if we use features that need it
+    if(featuresToUse->needFft()){
+
+        fft.SetFlag(fft.HalfSpectrum);
+        fft.fwd(blockFft, mBlock);
+
+    }
+
+    //---Calculate selected features
+    if(featuresToUse->rms){
+        blockFeatures(featureIdx) = calculateBlockRMS(asbBlock);
+        featureIdx += 1;
+    }
+
+    if(featuresToUse->zcr){
+        blockFeatures(featureIdx) = calculateZeroCrossRate(asbBlock);
+        featureIdx += 1;
+    }
+
+    if(featuresToUse->sf){
+        blockFeatures(featureIdx) = calculateSprectralFlux(blockFft);
+        featureIdx += 1;
+    }
+
+    if(featuresToUse->sc){
+        float blockSc = calculateSpectralCentroid(blockFft);
+        if(blockSc != blockSc){
+            DBG(blockSc);
+        }
+        blockFeatures(featureIdx) = blockSc;
+        featureIdx += 1;
+    }
+
+    if(featuresToUse->mfcc){
+        Eigen::RowVectorXf blockMFCC = calculateMFCC(blockFft, 44100); // FIXME: get file sample rate
+        blockFeatures.segment(featureIdx, 12) = blockMFCC; // insert vector in appropriate place
+        featureIdx += 12; // note 12 spots taken!
+    }
+
+    return blockFeatures;
+}
+
+float AnalysisEngine::calculateDistance(const Eigen::RowVectorXf &blockFeatures, const Eigen::RowVectorXf &avgRegionFeatures){
+
+    if(blockFeatures.size() < 2){ // use euclidean if only one value in feature vector, cosine not defined
+        return (blockFeatures - avgRegionFeatures).squaredNorm();
+    }
+
+    // cosine distance
+    float tmp1 = (blockFeatures.array() * avgRegionFeatures.array()).sum();
+    float tmp2 = sqrt(blockFeatures.array().pow(2).sum());
+    float tmp3 = sqrt(avgRegionFeatures.array().pow(2).sum());
+
+    if(tmp2 * tmp3 == 0){ // all features 0, e.g. rms and zcr of silence. No angle, so count it as unrelated
+        return 1;
+    }
+
+    return 1 - tmp1 / (tmp2 * tmp3);
+}
+
+float AnalysisEngine::calculateBlockRMS(AudioSampleBuffer &block){
+    
+    float runningTotal = 0;
+    float** channelArray = block.getArrayOfChannels();
+    
+    for(int j=0; j<block.getNumChannels(); j++){
+        for(int i=0; i<block.getNumSamples(); i++){
+            runningTotal += powf(channelArray[j][i], 2);
+        }
+    }
+    
+    float rms = sqrtf(runningTotal);
+    
+    return rms;
+}
+
+float AnalysisEngine::calculateZeroCrossRate(AudioSampleBuffer &block){
+    
+    int blockLength = block.getNumSamples();
+    int numZeroCrosses = 0;
+    float zcr;
+    
+    float** channelArray = block.getArrayOfChannels();
+    
+    for(int j=0; j<block.getNumChannels(); j++){
+        for(int i=1; i<blockLength; i++){
+            numZeroCrosses += abs(signum(channelArray[j][i]) - signum(channelArray[j][i-1]));
+        }
+    }
+    
+    zcr = 1/(2*float(blockLength)) * float(numZeroCrosses);
+    return zcr;
+}
+
+float AnalysisEngine::calculateSprectralFlux(Eigen::RowVectorXcf &blockFft){
+    return 0;
+}
+
+float AnalysisEngine::calculateSpectralCentroid(Eigen::RowVectorXcf &blockFft){
+    
+    int fftLength = blockFft.size();
+    
+    Eigen::RowVectorXf weights = Eigen::RowVectorXf::LinSpaced(Eigen::Sequential, fftLength, 0, fftLength-1);
+    
+    float sc = (blockFft.array().abs().pow(2) * weights.array()).sum() / blockFft.array().abs().pow(2).sum();
+    
+    if(sc != sc) sc = 0; // set nan to 0
+    
+    return sc;
+}
+
+Eigen::RowVectorXf AnalysisEngine::calculateMFCC(Eigen::RowVectorXcf &blockFft, int sampleRate){
+        
+    // coded by cameron from reference:
+    // http://practicalcryptography.com/miscellaneous/machine-learning/guide-mel-frequency-cepstral-coefficients-mfccs/
+    
+    //---Initial params
+    int numFilterBanks = 12; // num triangular filter banks applied to dft
+    int numBankPts = numFilterBanks+2; 
+    
+    // Set min and max frequencies for our filter bank. These can be anything
+    // but this was the suggestion for speech applications
+    float minFreq = 200.0f; // Hz, start filter banks here
+    float maxFreq = 8000.0f; // Hz, end here
+    // TODO maxFreq has to be less that sample rate
+
+    //---Convert to mel scale so we can get linearly spaced banks
+    float minMel = 1125.0f * log(1 + minFreq/700);
+    float maxMel = 1125.0f * log(1 + maxFreq/700);
+    
+    //---Calculate linearly spaced bank locations on mel scale
+    Array<float> melBankLocations;
+    for(int i=0; i<numBankPts; i++){
+        melBankLocations.add(minMel + i*((maxMel - minMel)/numFilterBanks));
+    }
+    
+    //---Convert bank pts back to hertz
+    Array<float> freqBankLocations;
+    for(int i=0; i<numBankPts; i++){
+        freqBankLocations.add((exp(melBankLocations[i] / 1125.0f) - 1) * 700);
+    }
+    
+    //---Round pts to nearest actual fft bin
+    Array<float> freqBankBinIdxs;
+    for(int i=0; i<numBankPts; i++){
+        freqBankBinIdxs.add(floor((windowSize/2+1)*freqBankLocations[i] / sampleRate));
+    }
+    
+    //---Get power spectrum estimate of dft
+    Eigen::RowVectorXf periodogram = (blockFft.array().abs().pow(2) / windowSize).matrix();
+    
+    //---Apply triangular banks to periodogram
+    Eigen::RowVectorXf logEnergies = Eigen::RowVectorXf::Zero(1, numFilterBanks);
+    for(int i=0; i<numFilterBanks; i++){
+                
+        int bankBinStart = freqBankBinIdxs[i]; // triangle starts one before filter center
+        int bankBinEnd = freqBankBinIdxs[i+2]; // ends one pt after
+        int numFftBins = bankBinEnd - bankBinStart;
+        
+        Eigen::RowVectorXf triangleBankValues = Eigen::RowVectorXf::Zero(1, numFftBins);
+
+        // create triangle filter banks
+        for(int j=0; j<numFftBins; j++){
+            if(j < float(numFftBins)/2){
+                triangleBankValues[j] = float(j) / (numFftBins / 2); // scale triangle filter from 0 to 1
+            }
+            else{
+                triangleBankValues[j] = (numFftBins - float(j)) / (numFftBins / 2); // scale 1 back to 0
+            }
+            //DBG(triangleBankValues[j]);
+        }
+        
+        // multiply filter banks with spectral power
+        float energy = (triangleBankValues.array() * periodogram.block(0, bankBinStart, 1, numFftBins).array()).sum();
+        
+        logEnergies[i] = log(jmax(energy, 1e-10f)); // silence would give -inf, which ends up in every distance
+    }
+    
+    // Take discrete cosine transform of log energies
+    // Ref: http://www.haberdar.org/Discrete-Cosine-Transform-Tutorial.htm
+    Eigen::RowVectorXf mfccs = Eigen::RowVectorXf::Zero(1, 12); float w;
+    for(int i=0; i<numFilterBanks; i++){
+        w = 0;
+        
+        for(int j=0; j<numFilterBanks-1; j++){
+            w += logEnergies[j] * cos(M_PI * (float(j)+1/2) * i / numFilterBanks);
+        }
+        mfccs[i] = w;
+    }
+    
+    return mfccs.transpose(); // return as column
+}
+
+void AnalysisEngine::getClusterRegions(ClusterParameters* clusterParams, Array<float>* distanceArray, float* maxDistance, Array<AudioRegion>* regions, SegaudioFile* targetFile, DistanceStatistics* distanceStats){
+    
+    regions->clear();
+    Array<int> acceptedBlocks; // holds all blocks under threshold
+    
+    int numBlocks = distanceArray->size();
+    
+    // take all blocks under threshold
+    for(int blockIdx=0; blockIdx<numBlocks; blockIdx++){
+        if((*distanceArray)[blockIdx] < clusterParams->threshold * (*maxDistance) * 1){
+            acceptedBlocks.add(blockIdx);
+        }
+    }
+
+    int numAcceptedBlocks = acceptedBlocks.size();
+    int regionStart = acceptedBlocks[0];
+    int regionEnd = acceptedBlocks[1];
+    
+    float connWidth = clusterParams->regionConnectionWidth*50.0f + 1; // connections up to 51 blocks
+    
+    // for blocks under threshold, create regions satisfying other cluster params (width of region and smoothing)
+    for(int blockIdx=1; blockIdx<numAcceptedBlocks; blockIdx++){
+        float regionFracWidth = (float(regionEnd) - float(regionStart)) / numBlocks;
+
+        if(acceptedBlocks[blockIdx] - acceptedBlocks[blockIdx-1] > connWidth){ // passes smoothing
+            if(isRegionWithinWidth(regionFracWidth, clusterParams)){ // passes width filter
+                regions->add(getRegionFromBlocks(regionStart, regionEnd, numBlocks, targetFile));
+            }
+            regionStart = acceptedBlocks[blockIdx]; // start next region
+            regionEnd = acceptedBlocks[blockIdx];
+        }
+        else{ // doesn't pass smoothing
+            regionEnd = acceptedBlocks[blockIdx]; // so end region
+            
+            // catch ending region
+            if(blockIdx == numAcceptedBlocks - 1 and isRegionWithinWidth(regionFracWidth, clusterParams)){
+                regions->add(getRegionFromBlocks(regionStart, regionEnd, numBlocks, targetFile));
+            }
+        }
+    }
+    
+    // invert the regions if asked
+    if(clusterParams->shouldInvertRegions){
+        invertClusterRegions(regions, targetFile);
+    }
+
+    scoreRegions(regions, numBlocks, targetFile, distanceStats);
+    
+}
+
+void AnalysisEngine::scoreRegions(Array<AudioRegion>* regions, int numBlocks, SegaudioFile* targetFile, DistanceStatistics* distanceStats){
+
+    if(distanceStats == nullptr or distanceStats->getNumBlocks() != numBlocks or numBlocks == 0){ // stats not built for these distances
+        return;
+    }
+
+    bool useSamples = (targetFile != nullptr and targetFile->getNumSamples() > 0);
+
+    for(int i=0; i<regions->size(); i++){
+        AudioRegion& region = regions->getReference(i);
+
+        int startBlock, endBlock;
+        if(useSamples and region.isSampleAccurate()){
+            int64 totalNumSamples = targetFile->getNumSamples();
+            startBlock = int(region.getStartSample(totalNumSamples) / windowSize);
+            endBlock = int((region.getEndSample(totalNumSamples) + windowSize - 1) / windowSize); // partial last block counts
+        }
+        else{
+            startBlock = int(floor(region.getStart() * numBlocks));
+            endBlock = int(ceil(region.getEnd() * numBlocks));
+        }
+        endBlock = jmax(endBlock, startBlock + 1); // single block regions still get a score
+
+        region.setScore(distanceStats->getMeanDistance(startBlock, endBlock), distanceStats->getMinDistance(startBlock, endBlock), float(distanceStats->getAreaDistance(startBlock, endBlock)));
+    }
+}
+
+AudioRegion AnalysisEngine::getRegionFromBlocks(int startBlock, int endBlock, int numBlocks, SegaudioFile* targetFile){
+
+    if(targetFile == nullptr or targetFile->getNumSamples() == 0){
+        return AudioRegion(startBlock, endBlock, numBlocks);
+    }
+
+    // target blocks start at sample 0 and are windowSize long, so block boundaries are exact samples
+    int64 totalNumSamples = targetFile->getNumSamples();
+    int64 startSample = int64(startBlock) * windowSize;
+    int64 endSample = jmin(int64(endBlock) * windowSize, totalNumSamples);
+
+    return AudioRegion(startSample, endSample, totalNumSamples, targetFile->getSampleRate());
+}
+
+bool AnalysisEngine::isRegionWithinWidth(float regionFracWidth, ClusterParameters *clusterParams){
+    
+    if(regionFracWidth > clusterParams->minRegionTimeWidth / 10 and regionFracWidth < clusterParams->maxRegionTimeWidth){
+        return true;
+    }
+    
+    return false;
+}
+
+
+
+int AnalysisEngine::signum(float value){
+    if(value > 0) return 1;
+    if(value < 0) return -1;
+    return 0;
+}
+
+void AnalysisEngine::invertClusterRegions(Array<AudioRegion>* regions, SegaudioFile* targetFile){
+    
+    Array<AudioRegion> invertedRegions;
+    
+    int numRegions = regions->size();
+
+    if(targetFile != nullptr and targetFile->getNumSamples() > 0){ // keep inverted regions sample accurate
+
+        int64 totalNumSamples = targetFile->getNumSamples();
+        double sampleRate = targetFile->getSampleRate();
+
+        for(int i=0; i<numRegions-1; i++){ // link ends and starts of regions to invert them
+            invertedRegions.add(AudioRegion((*regions)[i].getEndSample(totalNumSamples), (*regions)[i+1].getStartSample(totalNumSamples), totalNumSamples, sampleRate));
+        }
+
+        if((*regions)[0].getStartSample(totalNumSamples) != 0){ // handle case where first region does not start at 0
+            invertedRegions.add(AudioRegion(int64(0), (*regions)[0].getStartSample(totalNumSamples), totalNumSamples, sampleRate));
+        }
+
+        if((*regions)[numRegions-1].getEndSample(totalNumSamples) != totalNumSamples){ // handle case where last region does not end at 1
+            invertedRegions.add(AudioRegion((*regions)[numRegions-1].getEndSample(totalNumSamples), totalNumSamples, totalNumSamples, sampleRate));
+        }
+    }
+    else{
+        for(int i=0; i<numRegions-1; i++){ // link ends and starts of regions to invert them
+            invertedRegions.add(AudioRegion((*regions)[i].getEnd(), (*regions)[i+1].getStart()));
+        }
+
+        if((*regions)[0].getStart() != 0.0f){ // handle case where first region does not start at 0
+            invertedRegions.add(AudioRegion(0.0f, (*regions)[0].getStart()));
+        }
+
+        if((*regions)[numRegions-1].getEnd() != 1.0f){ // handle case where last region does not end at 1
+            invertedRegions.add(AudioRegion((*regions)[numRegions-1].getEnd(), 1.0f));
+        }
+    }
+
+    regions->clear();
+    for(int i=0; i<invertedRegions.size(); i++){ // replace our old regions with the new inverted ones
+        regions->add(invertedRegions[i]);
+    }
+}
+
+void AnalysisEngine::findRegionsGridSearch(SearchParameters* searchParams, Array<float>* distanceArray, float* maxDistance, ClusterParameters* bestParams, Array<AudioRegion>* regions, SegaudioFile* targetFile, DistanceStatistics* distanceStats){
+    
+    ClusterParameters candidateParams;
+    int numTestIncrements = 100; // grid size
+    float minCost = FLT_MAX, cost;
+    
+    if(searchParams->useWidthFilter){
+        candidateParams.minRegionTimeWidth = searchParams->minWidth;
+        candidateParams.maxRegionTimeWidth = searchParams->maxWidth;
+    }
+    
+    for(int i=0; i<numTestIncrements; i++){
+        
+        candidateParams.threshold = float(i) / (numTestIncrements);
+        
+//        for(int j=0; j<numTestIncrements; j++){ // was iterating over smoothing, but just threshold for now
+            candidateParams.regionConnectionWidth = 0;// float(j) / numTestIncrements;
+        
+        
+            getClusterRegions(&candidateParams, distanceArray, maxDistance, regions, targetFile, distanceStats);
+
+            if(regions->size() == searchParams->numRegions){
+                DBG("match: " + String(candidateParams.threshold) + " " + String(candidateParams.regionConnectionWidth) + " " + String(cost));
+            }
+
+//            if(regions->size() < searchParams->numRegions){
+//                continue; // skip if the smoothing parameter past the target num
+//            }
+
+            cost = getRegionCost(regions, searchParams);
+            if(cost < minCost){
+                bestParams->threshold = candidateParams.threshold;
+                bestParams->regionConnectionWidth = candidateParams.regionConnectionWidth;
+                minCost = cost;
+            }
+//        }
+    }
+}
+
+void AnalysisEngine::findRegionsBinarySearch(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams, Array<AudioRegion>* regions){
+
+    ClusterParameters candidateParams;
+    float minCost = FLT_MAX, cost;
+    
+    if(searchParams->useWidthFilter){
+        candidateParams.minRegionTimeWidth = searchParams->minWidth;
+        candidateParams.maxRegionTimeWidth = searchParams->maxWidth;
+    }
+    
+    candidateParams.regionConnectionWidth = 0;
+    int numChanges = 0; int numRegions = 0; int prevNumRegions = 0;
+    float leftBoundary = 0; float rightBoundary = 1;
+
+    while(regions->size() != searchParams->numRegions){
+        
+        candidateParams.threshold = (rightBoundary - leftBoundary)/2;
+
+        cost = getRegionCost(regions, searchParams);
+        if(cost < minCost){
+            bestParams->threshold = candidateParams.threshold;
+            bestParams->regionConnectionWidth = candidateParams.regionConnectionWidth;
+            minCost = cost;
+            
+            numChanges = 0;
+        }
+        else{
+            numChanges += 1;
+        }
+        
+        numRegions = regions->size();
+        
+        prevNumRegions = numRegions;
+        
+        if(numChanges > 100){
+            break;
+        }
+        
+        if(numRegions == searchParams->numRegions){
+            DBG("match: " + String(candidateParams.threshold) + " " + String(candidateParams.regionConnectionWidth) + " " + String(cost));
+        }
+        
+        if(numRegions > searchParams->numRegions){
+            rightBoundary = (rightBoundary - leftBoundary)/2;
+        }
+        else{
+            leftBoundary = (rightBoundary - leftBoundary)/2;
+        }
+    }
+}
+
+void findRegionsGradientDescent(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams){
+    
+    int numIterations = 1;
+    float convergePrecision = 0.00001;
+    float stepSize = 0.001f;
+    
+    float thresh_old = 0;
+    float thresh_new = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);;
+    float smooth_old = 0;
+    float smooth_new = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);;
+    
+    for(int i=0; i<numIterations; i++){
+        
+//        while(abs(thresh_new - thresh_old) > convergePrecision){
+//            
+//            thresh_old = thresh_new;
+//            thresh_new = thresh_old - stepSize * 
+//            
+//        }
+        
+    }
+}
+
+
+
+float AnalysisEngine::getRegionCost(Array<AudioRegion>* regions, SearchParameters* searchParams){
+ 
+    float weightNumRegion = 1.0f; float weightPercentage = 2.0f; // TODO: play with these values
+    float cost;
+    int numRegions = regions->size();
+    
+    float regionFilePercentage = 0.0f;
+    for(int i=0; i<numRegions; i++){
+        regionFilePercentage += ((*regions)[i].getEnd() - (*regions)[i].getStart());
+    }
+    
+//    DBG("file percentage" + String(regionFilePercentage));
+    
+    cost = weightNumRegion*pow(abs(searchParams->numRegions - numRegions), 2) + weightPercentage*pow(fabs(searchParams->filePercentage - regionFilePercentage) + 1, 2);
+    
+    return cost;
+}
+
+bool AnalysisEngine::saveRegionsToTxtFile(Array<AudioRegion>* regions, SegaudioFile* sourceFile, File &destinationFile){
+    
+    // streamed region by region, the file's extension picks CSV, JSON Lines or binary
+    RegionBoundaryWriter::Format format = RegionBoundaryWriter::getFormatForFile(destinationFile);
+    return RegionBoundaryWriter::writeRegions(regions, destinationFile, format, sourceFile->getNumSamples(), sourceFile->getSampleRate());
+}
+
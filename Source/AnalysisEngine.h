@@ -0,0 +1,281 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef ANALYSISENGINE_H_INCLUDED
+#define ANALYSISENGINE_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+#include "SegaudioModel.h"
+#include "OnlineRegionSegmenter.h"
+#include "RegionBoundaryWriter.h"
+#include "Eigen.h"
+#include "Eigen/FFT.h"
+#include <math.h>
+
+//==============================================================================
+/*
+    Feature extraction, distances, clustering and region search without any GUI. Every call blocks the calling
+    thread, so a server or command line tool can use it directly, and AudioAnalysisController runs it on its worker
+    thread behind a progress window. Progress, status and cancelling go through the virtual hooks, which do nothing
+    here. Calculations must not overlap on one engine, use one engine per thread.
+*/
+class AnalysisEngine
+{
+
+public:
+
+    AnalysisEngine();
+    virtual ~AnalysisEngine();
+
+    /*! calculates distances between the reference region and each block of the target file, the similarity function
+        @param SegaudioFile* refFile: file with reference region
+        @param AudioRegion refRegion: region to use as reference
+        @param SegaudioFile* targetFile: file to compare with reference region
+        @param SignalFeaturesToUse* featuresToUse: features to calculate in feature matrix
+        @param ClusterParameters* onlineClusterParams: finds regions while calculating, see takeOnlineRegions (can be nullptr)
+        @param Array<float>* distanceArray: holds the distances calculated, cleared first
+        @param float* maxDistance: holds the maximum distance, so we don't have to calculate later
+        @return bool: false if cancelled, distanceArray is incomplete then
+    */
+    bool calculateSimilarity(SegaudioFile* refFile, AudioRegion refRegion, SegaudioFile* targetFile, SignalFeaturesToUse* featuresToUse, ClusterParameters* onlineClusterParams, Array<float>* distanceArray, float* maxDistance);
+
+    /*! averages the features of the blocks in the reference region, what each target block is compared with. For
+        comparing many targets with one reference, so the reference is only read once
+        @param SegaudioFile* refFile: file with reference region
+        @param AudioRegion refRegion: region to use as reference
+        @param SignalFeaturesToUse* featuresToUse: features to calculate
+        @return Eigen::RowVectorXf: one value per selected feature (12 for mfcc)
+    */
+    Eigen::RowVectorXf calculateReferenceFeatures(SegaudioFile* refFile, AudioRegion refRegion, SignalFeaturesToUse* featuresToUse);
+
+    /*! calculates the similarity function of a target against reference features from calculateReferenceFeatures,
+        can be called from many engines at once with the same features
+        @param const Eigen::RowVectorXf &referenceFeatures
+        @param SegaudioFile* targetFile: file to compare with the reference
+        @param SignalFeaturesToUse* featuresToUse: the features referenceFeatures were calculated with
+        @param ClusterParameters* onlineClusterParams: finds regions while calculating, see takeOnlineRegions (can be nullptr)
+        @param Array<float>* distanceArray: holds the distances calculated, cleared first
+        @param float* maxDistance: holds the maximum distance
+        @return bool: false if cancelled, distanceArray is incomplete then
+    */
+    bool calculateTargetSimilarity(const Eigen::RowVectorXf &referenceFeatures, SegaudioFile* targetFile, SignalFeaturesToUse* featuresToUse, ClusterParameters* onlineClusterParams, Array<float>* distanceArray, float* maxDistance);
+
+    /*! moves regions found during the calculation since the last call, call from message thread
+        @param Array<AudioRegion>* regions: regions are added to the end
+        @return int: number of regions added
+    */
+    int takeOnlineRegions(Array<AudioRegion>* regions);
+
+    /*! calculates the features matrix for the selected features
+        @param SegaudioFile* file: file to read samples from, a block at a time
+        @param SignalFeaturesToUse* featuresToUse: which features to calculate
+        @param AudioRegion region: for reference, this is a part of reference file, for target this is region from 0 to 1
+        @return Eigen::MatrixXf: x dimensional matrix, since we don't know how many features
+    */
+    Eigen::MatrixXf calculateFeatureMatrix(SegaudioFile* file, SignalFeaturesToUse* featuresToUse, AudioRegion region);
+
+    /*! calculates the regions to extract given the similarity function
+        @param ClusterParameters* clusterParams: values from UI that determine regions (ie threshold of similarity)
+        @param Array<float>* distanceArray: similarity function data points
+        @param float* maxDistance: maximium distance
+        @param Array<AudioRegion>* regions: holds the calculated regions
+        @param SegaudioFile* targetFile: file the distances are from, for sample accurate regions (can be nullptr)
+        @param DistanceStatistics* distanceStats: built from distanceArray, for scoring regions (can be nullptr)
+        @return void
+    */
+    void getClusterRegions(ClusterParameters* clusterParams, Array<float>* distanceArray, float* maxDistance,  Array<AudioRegion>* regions, SegaudioFile* targetFile, DistanceStatistics* distanceStats);
+
+    /*! sets mean, min and area distance on each region, O(1) per region
+        @param Array<AudioRegion>* regions: regions to score
+        @param int numBlocks: number of blocks in similarity function
+        @param SegaudioFile* targetFile: file the regions are from (can be nullptr)
+        @param DistanceStatistics* distanceStats: built from the similarity function
+        @return void
+    */
+    void scoreRegions(Array<AudioRegion>* regions, int numBlocks, SegaudioFile* targetFile, DistanceStatistics* distanceStats);
+
+    /*! checks in if the width of a candidate region is within width filter
+        @param float regionFracWidth: raw width of region
+        @param ClusterParameters* clusterParams: get width values from here
+        @return bool
+    */
+    bool isRegionWithinWidth(float regionFracWidth, ClusterParameters* clusterParams);
+
+    /*! get sign, used for zero cross calculation
+        @param float value: value for which to get sign
+        @return int: 1 for positive, -1 for negative, 0 if 0
+    */
+    int signum(float value);
+
+    /*! given a set of cluster regions, get new set connecting ends with starts and starts with ends
+        @param Array<AudioRegion>* regions: regions to invert and replace
+        @param SegaudioFile* targetFile: file the regions are from, for sample accurate regions (can be nullptr)
+        @return void
+    */
+    void invertClusterRegions(Array<AudioRegion>* regions, SegaudioFile* targetFile);
+
+    /*! grid search of cluster parameters that provide lowest cost from getRegionCost
+        @param SearchParameters* searchParams: params from search of UI
+        @param Array<float>* distanceArray: similarity function data points
+        @param float* maxDistance: max distance of similarity function
+        @param ClusterParameters* bestParams: params that give lowest cost to pass to model
+        @param Array<AudioRegion>* regions: regions to calculate from best params
+        @param SegaudioFile* targetFile: file the distances are from, for sample accurate regions (can be nullptr)
+        @param DistanceStatistics* distanceStats: built from distanceArray, for scoring regions (can be nullptr)
+        @return void
+    */
+    void findRegionsGridSearch(SearchParameters* searchParams, Array<float>* distanceArray, float* maxDistance, ClusterParameters* bestParams, Array<AudioRegion>* regions, SegaudioFile* targetFile, DistanceStatistics* distanceStats);
+
+    // not used, but leaving for now
+    void findRegionsBinarySearch(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams, Array<AudioRegion>* regions);
+
+    // not implemented, may be best option for search
+    void findRegionsGradientDescent(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams);
+
+    /*! assigns a cost to the regions calculated from a set of cluster parameters
+        @param Array<AudioRegion>* regions: regions used for calculating cost of cluster params
+        @param SearchParameters* searchParams: used to evaluate cost
+        @return float: cost
+    */
+    float getRegionCost(Array<AudioRegion>* regions, SearchParameters* searchParams);
+
+    /*! saves region boundaries with a RegionBoundaryWriter, start and end in seconds, start and end sample, then
+        mean, min and area distance (empty for regions without scores). A ".jsonl" or ".bin" extension selects
+        JSON Lines or the binary format, anything else is saved as CSV
+        @param Array<AudioRegion>* regions: regions to save
+        @param SegaudioFile* sourceFile: used for getting boundary values in seconds
+        @param File &destinationFile: file to save to
+        @return bool
+    */
+    bool saveRegionsToTxtFile(Array<AudioRegion>* regions, SegaudioFile* sourceFile, File &destinationFile);
+
+    /*! creates a region from a range of blocks in the similarity function
+        @param int startBlock
+        @param int endBlock
+        @param int numBlocks: number of blocks in similarity function
+        @param SegaudioFile* targetFile: file the blocks are from, region is only fractional if nullptr
+        @return AudioRegion
+    */
+    AudioRegion getRegionFromBlocks(int startBlock, int endBlock, int numBlocks, SegaudioFile* targetFile);
+
+protected:
+
+    /*! checked before each block while calculating
+        @return bool: true stops the calculation
+    */
+    virtual bool isCalculationCancelled();
+
+    /*! called while calculating
+        @param double progress: 0 to 1
+        @return void
+    */
+    virtual void setCalculationProgress(double progress);
+
+    /*! called when a calculation step starts
+        @param const String &status
+        @return void
+    */
+    virtual void setCalculationStatus(const String &status);
+
+    /*! called on the calculating thread when regions were added for takeOnlineRegions
+        @return void
+    */
+    virtual void onlineRegionsFound();
+
+    CriticalSection onlineRegionsLock; // guards onlineRegions
+    Array<AudioRegion> onlineRegions; // found while calculating, waiting for takeOnlineRegions
+
+private:
+
+    Eigen::MatrixXf refFeatureMat; // feature matrix for reference region, maybe doesn't need to be a member
+
+    int windowSize; // size of blocks and fft, can be made variable in UI easily if we want
+    int onlineLookAheadBlocks; // blocks the online segmenter waits before deciding on one
+
+    OnlineRegionSegmenter onlineSegmenter; // only used while calculating
+
+    double progressStart; // start of progress range for the matrix being calculated
+    double progressRange; // size of progress range for the matrix being calculated
+
+    /*! gets the blocks a region covers in a file
+        @param SegaudioFile* file
+        @param AudioRegion region
+        @param int* startBlock: holds first block
+        @param int* endBlock: holds block after the last, last one is not processed
+        @return void
+    */
+    void getBlockRange(SegaudioFile* file, AudioRegion region, int* startBlock, int* endBlock);
+
+    /*! calculates the selected features for one block, so target blocks can be used as soon as they are done
+        @param SegaudioFile* file: file to read the block from
+        @param SignalFeaturesToUse* featuresToUse: which features to calculate
+        @param int blockIdx: block in file
+        @return Eigen::RowVectorXf: one value per selected feature (12 for mfcc)
+    */
+    Eigen::RowVectorXf calculateBlockFeatures(SegaudioFile* file, SignalFeaturesToUse* featuresToUse, int blockIdx);
+
+    /*! distance between features of a block and the averaged reference features, euclidean for one feature,
+        cosine otherwise
+        @param const Eigen::RowVectorXf &blockFeatures
+        @param const Eigen::RowVectorXf &avgRegionFeatures
+        @return float
+    */
+    float calculateDistance(const Eigen::RowVectorXf &blockFeatures, const Eigen::RowVectorXf &avgRegionFeatures);
+
+    /*! calculate RMS for block of audio samples
+        @param AudioSampleBuffer &block
+        @return float: RMS val
+    */
+    float calculateBlockRMS(AudioSampleBuffer &block);
+
+    /*! calculate zero cross rate for block of audio samples
+        @param AudioSampleBuffer &block
+        @return float: zero cross rate val
+    */
+    float calculateZeroCrossRate(AudioSampleBuffer &block);
+
+    /*! calculate spectral flux from an fft of a block
+        @param Eigen::RowVectorXcf &blockFft
+        @return float: spectral flux val
+    */
+    float calculateSprectralFlux(Eigen::RowVectorXcf &blockFft);
+
+    /*! calculate spectral centroid from an fft of a block
+        @param Eigen::RowVectorXcf &blockFft
+        @return float: spectral centroid val
+    */
+    float calculateSpectralCentroid(Eigen::RowVectorXcf &blockFft);
+
+    /*! calculate MFCCs from an fft of a block
+        @param Eigen::RowVectorXcf &blockFft
+        @param int sampleRate
+        @return Eigen::RowVectorXf: coefficient vals
+    */
+    Eigen::RowVectorXf calculateMFCC(Eigen::RowVectorXcf &blockFft, int sampleRate);
+
+    /*! sets the progress bar for a block inside the current progress range
+        @param int numProcessedBlocks
+        @param int numBlocksToProcess
+        @return void
+    */
+    void setBlockProgress(int numProcessedBlocks, int numBlocksToProcess);
+};
+
+
+
+#endif  // ANALYSISENGINE_H_INCLUDED
@@ -21,11 +21,17 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 #include "JuceHeader.h"
 #include "AudioRegion.h"
 #include "SegaudioModel.h"
-#include "Eigen.h"
-#include "Eigen/FFT.h"
-#include <math.h>
+#include "AnalysisEngine.h"
+#include "ExportQueue.h"
 
-class AudioAnalysisController : public ActionListener,
+//==============================================================================
+/*
+    Runs the AnalysisEngine on a worker thread behind a progress window for the GUI, hands results to the model on
+    the message thread and queues exports.
+*/
+class AudioAnalysisController : public AnalysisEngine,
+                                public ActionListener,
+                                public ActionBroadcaster,
                                 public ThreadWithProgressWindow
 {
     
@@ -34,144 +40,99 @@ public:
     AudioAnalysisController();
     ~AudioAnalysisController();
 
-    /*! calculate distances between reference region and target file for similarity function
+    /*! starts calculating distances between reference region and target file for similarity function on the
+        worker thread, sends "similarityCalculated" when the results are in the model or "similarityCancelled".
+        The reference features are only calculated on the first call after clearReferenceFeatures
         @param Array<float>* distanceArray: holds the distances calculated
         @param float* maxDistance: holds the maximum distance, so we don't have to calculate later
-        @param AudioSampleBuffer* refRegionBuffer: samples from reference region
-        @param AudioSampleBuffer* targetBuffer: samples from target file
+        @param SegaudioFile* refFile: file with reference region
+        @param SegaudioFile* targetFile: file to compare with reference region
         @param Array<AudioRegion>* refRegions: region (one for now) to use a reference
         @param SignalFeaturesToUse* featuresToUse: features to calculate in feature matrix
         @return void
     */
-    void calculateDistances(Array<float>* distanceArray, float* maxDistance, AudioSampleBuffer* refRegionBuffer, AudioSampleBuffer* targetBuffer, Array<AudioRegion>* refRegions, SignalFeaturesToUse* featuresToUse);
-
-    /*! calculates the features matrix for the selected features
-        @param AudioSampleBuffer* buffer: actual samples to use for calculation
-        @param SignalFeaturesToUse* featuresToUse: which features to calculate
-        @param AudioRegion region: for reference, this is a part of reference file, for target this is region from 0 to 1
-        @return Eigen::MatrixXf: x dimensional matrix, since we don't know how many features
-    */
-    Eigen::MatrixXf calculateFeatureMatrix(AudioSampleBuffer* buffer, SignalFeaturesToUse* featuresToUse, AudioRegion region);
+    void calculateDistances(Array<float>* distanceArray, float* maxDistance, SegaudioFile* refFile, SegaudioFile* targetFile, Array<AudioRegion>* refRegions, SignalFeaturesToUse* featuresToUse);
 
-    /*! handle action callbacks
-        @param const String &message
+    /*! has the next calculateDistances calculate the reference features again, call when the reference file,
+        region or features change. Every target after that is compared with the same features
         @return void
     */
-    virtual void actionListenerCallback(const String &message);
+    void clearReferenceFeatures();
 
-    /*! calculates the regions to extract given the similarity function
-        @param ClusterParameters* clusterParams: values from UI that determine regions (ie threshold of similarity)
-        @param Array<float>* distanceArray: similarity function data points
-        @param float* maxDistance: maximium distance
-        @param Array<AudioRegion>* regions: holds the calculated regions
+    /*! sets up finding regions while the next calculateDistances is still running, regions found are announced
+        with "onlineRegionsFound", call before calculateDistances
+        @param ClusterParameters* clusterParams: cluster params to use, nullptr to only find regions when finished
         @return void
     */
-    void getClusterRegions(ClusterParameters* clusterParams, Array<float>* distanceArray, float* maxDistance,  Array<AudioRegion>* regions);
-
-    /*! checks in if the width of a candidate region is within width filter
-        @param float regionFracWidth: raw width of region
-        @param ClusterParameters* clusterParams: get width values from here
-        @return bool
-    */
-    bool isRegionWithinWidth(float regionFracWidth, ClusterParameters* clusterParams);
-
-    /*! get sign, used for zero cross calculation
-        @param float value: value for which to get sign
-        @return int: 1 for positive, -1 for negative, 0 if 0
-    */
-    int signum(float value);
+    void setOnlineSegmentation(ClusterParameters* clusterParams);
 
-    /*! given a set of cluster regions, get new set connecting ends with starts and starts with ends
-        @param Array<AudioRegion>* regions: regions to invert and replace
-        @return void
-    */
-    void invertClusterRegions(Array<AudioRegion>* regions);
-
-    /*! grid search of cluster parameters that provide lowest cost from getRegionCost
-        @param SearchParameters* searchParams: params from search of UI
-        @param Array<float>* distanceArray: similarity function data points
-        @param float* maxDistance: max distance of similarity function
-        @param ClusterParameters* bestParams: params that give lowest cost to pass to model
-        @param Array<AudioRegion>* regions: regions to calculate from best params
+    /*! handle action callbacks
+        @param const String &message
         @return void
     */
-    void findRegionsGridSearch(SearchParameters* searchParams, Array<float>* distanceArray, float* maxDistance, ClusterParameters* bestParams, Array<AudioRegion>* regions);
-
-
-    // not used, but leaving for now
-    void findRegionsBinarySearch(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams, Array<AudioRegion>* regions);
-
-    // not implemented, may be best option for search
-    void findRegionsGradientDescent(SearchParameters* searchParams, Array<float>* distanceArray, ClusterParameters* bestParams);
-
-    /*! assigns a cost to the regions calculated from a set of cluster parameters
-        @param Array<AudioRegion>* regions: regions used for calculating cost of cluster params
-        @param SearchParameters* searchParams: used to evaluate cost
-        @return float: cost
-    */
-    float getRegionCost(Array<AudioRegion>* regions, SearchParameters* searchParams);
+    virtual void actionListenerCallback(const String &message);
 
-    /*! saves regions of audio to audio file(s)
+    /*! queues saving regions of audio to audio file(s), keeping the source's bit depth where the format allows. PCM
+        WAV sources exported to WAV are copied byte for byte. Files are written in the background by the export
+        queue, which sends "exportStarted" and then "regionsExported" or "exportCancelled"
         @param Array<AudioRegion>* regions: regions to save
         @param SegaudioFile* sourceFile: file to save from
         @param File &destinationFile: file(s) to save to
-        @param bool useSingleFile: save all regions into one file or multiple files
-        @return bool
+        @param ExportParameters* exportParams: one or multiple files, the format, and gaps or crossfades in one file
+        @return bool: false if the format is unknown
     */
-    bool saveRegionsToAudioFile(Array<AudioRegion>* regions, SegaudioFile* sourceFile, File &destinationFile, bool useSingleFile);
-
-    /*! saves region boundaries in seconds in a CSV
-        @param Array<AudioRegion>* regions: regions to save
-        @param SegaudioFile* sourceFile: used for getting boundary values in seconds
-        @param File &destinationFile: file to save to
-        @return bool
-    */
-    bool saveRegionsToTxtFile(Array<AudioRegion>* regions, SegaudioFile* sourceFile, File &destinationFile);
-    
-private:
-    
-    AudioFormatManager* formatManager; // handles audio format for creating readers and writers
-    
-    Eigen::MatrixXf refFeatureMat; // feature matrix for reference region, maybe doesn't need to be a member
-    Eigen::MatrixXf targetFeatureMat; // feature matrix for target file, maybe doesn't need to be a member
+    bool saveRegionsToAudioFile(Array<AudioRegion>* regions, SegaudioFile* sourceFile, File &destinationFile, ExportParameters* exportParams);
 
-    int windowSize; // size of blocks and fft, can be made variable in UI easily if we want
-
-    /*! calculate RMS for block of audio samples
-        @param AudioSampleBuffer &block
-        @return float: RMS val
+    /*! queues saving the regions of many files as one export, read in the plan's order
+        @param BatchExportPlan* plan: deleted by the export queue
+        @param ExportParameters* exportParams: one or multiple files per source, the format, and gaps or crossfades
+        @return bool: false if the format is unknown
     */
-    float calculateBlockRMS(AudioSampleBuffer &block);
+    bool saveBatchToAudioFiles(BatchExportPlan* plan, ExportParameters* exportParams);
 
-    /*! calculate zero cross rate for block of audio samples
-        @param AudioSampleBuffer &block
-        @return float: zero cross rate val
+    /*! gets the queue exports run on, for its progress, cancelling and the summary of the last export
+        @return ExportQueue*
     */
-    float calculateZeroCrossRate(AudioSampleBuffer &block);
+    ExportQueue* getExportQueue();
 
-    /*! calculate spectral flux from an fft of a block
-        @param Eigen::RowVectorXcf &blockFft
-        @return float: spectral flux val
-    */
-    float calculateSprectralFlux(Eigen::RowVectorXcf &blockFft);
+private:
+    
+    AudioFormatManager* formatManager; // handles audio format for creating readers and writers
 
-    /*! calculate spectral centroid from an fft of a block
-        @param Eigen::RowVectorXcf &blockFft
-        @return float: spectral centroid val
-    */
-    float calculateSpectralCentroid(Eigen::RowVectorXcf &blockFft);
+    ExportQueue exportQueue; // writes exports one after another in the background
 
-    /*! calculate MFCCs from an fft of a block
-        @param Eigen::RowVectorXcf &blockFft
-        @param int sampleRate
-        @return Eigen::RowVectorXf: coefficient vals
+    /*! calculates the distances for the current job on the worker thread
+        @return void
     */
-    Eigen::RowVectorXf calculateMFCC(Eigen::RowVectorXcf &blockFft, int sampleRate);
+    void run();
 
-    /*! dummy implementation so we can use JUCE progess bar for calculation
+    /*! called on the message thread when run() finishes, hands the results to the model
+        @param bool userPressedCancel
         @return void
     */
-    void run();
+    void threadComplete(bool userPressedCancel);
+
+    // AnalysisEngine hooks, mapped to the progress window and "onlineRegionsFound"
+    bool isCalculationCancelled();
+    void setCalculationProgress(double progress);
+    void setCalculationStatus(const String &status);
+    void onlineRegionsFound();
+
+    // current job, set by calculateDistances and read by the worker thread
+    Array<float>* jobDistanceArray; // model array the results go to when finished
+    float* jobMaxDistance; // model max distance the result goes to when finished
+    SegaudioFile* jobRefFile;
+    AudioRegion jobRefRegion; // copy, so region edits during the calculation don't matter
+    SignalFeaturesToUse jobFeaturesToUse;
+    bool jobUsesOnlineSegmentation;
+    ClusterParameters jobClusterParams; // copy, sliders can move during the calculation
+    SegaudioFile* jobTargetFile;
+
+    Eigen::RowVectorXf referenceFeatures; // averaged over the reference region, shared by all targets
+    bool isReferenceCalculated; // set by the worker thread, only read while it isn't running
+
+    Array<float> pendingDistances; // distances calculated by the worker thread
+    float pendingMaxDistance;
 
 };
 
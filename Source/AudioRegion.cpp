@@ -20,11 +20,27 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 AudioRegion::AudioRegion(){
     startValue = 0;
     endValue = 0;
+
+    startSample = 0;
+    endSample = 0;
+    sampleRate = 0;
+
+    isScored = false;
+    meanDistance = 0;
+    minDistance = 0;
+    areaDistance = 0;
 }
 
 AudioRegion::AudioRegion(float start, float end):
     startValue(start),
-    endValue(end)
+    endValue(end),
+    startSample(0),
+    endSample(0),
+    sampleRate(0),
+    isScored(false),
+    meanDistance(0),
+    minDistance(0),
+    areaDistance(0)
 {
     // check for out of bounds values
     if(startValue < 0 || startValue > 1) startValue = 0;
@@ -37,6 +53,15 @@ AudioRegion::AudioRegion(float start, float end):
 }
 
 AudioRegion::AudioRegion(float start, float end, float referenceWidth){
+
+    startSample = 0;
+    endSample = 0;
+    sampleRate = 0;
+
+    isScored = false;
+    meanDistance = 0;
+    minDistance = 0;
+    areaDistance = 0;
     
     startValue = start / referenceWidth;
     endValue = end / referenceWidth;
@@ -51,6 +76,34 @@ AudioRegion::AudioRegion(float start, float end, float referenceWidth){
 
 }
 
+AudioRegion::AudioRegion(int64 start, int64 end, int64 totalNumSamples, double fileSampleRate):
+    startSample(start),
+    endSample(end),
+    sampleRate(fileSampleRate),
+    isScored(false),
+    meanDistance(0),
+    minDistance(0),
+    areaDistance(0)
+{
+    // check for out of bounds values
+    if(startSample < 0 || startSample > totalNumSamples) startSample = 0;
+    if(endSample > totalNumSamples || endSample < 0) endSample = totalNumSamples;
+
+    if(endSample < startSample){
+        endSample = startSample;
+    }
+
+    // fractions in double so long files don't lose samples before drawing
+    if(totalNumSamples > 0){
+        startValue = float(double(startSample) / double(totalNumSamples));
+        endValue = float(double(endSample) / double(totalNumSamples));
+    }
+    else{
+        startValue = 0;
+        endValue = 0;
+    }
+}
+
 AudioRegion::~AudioRegion(){
     
 }
@@ -110,6 +163,54 @@ float AudioRegion::getEnd(float referenceWidth){
     }
 }
 
+int64 AudioRegion::getStartSample(int64 totalNumSamples){
+    if(isSampleAccurate()){
+        return startSample;
+    }
+    return int64(floor(double(startValue) * double(totalNumSamples)));
+}
+
+int64 AudioRegion::getEndSample(int64 totalNumSamples){
+    if(isSampleAccurate()){
+        return endSample;
+    }
+    return int64(floor(double(endValue) * double(totalNumSamples)));
+}
+
+double AudioRegion::getSampleRate(){
+    return sampleRate;
+}
+
+bool AudioRegion::isSampleAccurate(){
+    if(sampleRate > 0){
+        return true;
+    }
+    return false;
+}
+
+void AudioRegion::setScore(float mean, float min, float area){
+    meanDistance = mean;
+    minDistance = min;
+    areaDistance = area;
+    isScored = true;
+}
+
+bool AudioRegion::hasScore(){
+    return isScored;
+}
+
+float AudioRegion::getMeanDistance(){
+    return meanDistance;
+}
+
+float AudioRegion::getMinDistance(){
+    return minDistance;
+}
+
+float AudioRegion::getAreaDistance(){
+    return areaDistance;
+}
+
 bool AudioRegion::isInitialized(){
     if(endValue != 0){
         return true;
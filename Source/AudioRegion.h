@@ -38,6 +38,14 @@ public:
         @param float end: value between 0 and reference Width
     */
     AudioRegion(float start, float end, float referenceWidth);
+
+    /*! creates sample accurate region, fractions are kept for drawing
+        @param int64 start: first sample of region
+        @param int64 end: sample after last sample of region
+        @param int64 totalNumSamples: length of file in samples
+        @param double fileSampleRate: sample rate of file
+    */
+    AudioRegion(int64 start, int64 end, int64 totalNumSamples, double fileSampleRate);
     ~AudioRegion();
 
     /*! gets size of region
@@ -87,6 +95,45 @@ public:
     */
     float getEnd(float referenceWidth);
 
+    /*! gets first sample of region, exact for sample accurate regions
+        @param int64 totalNumSamples: length of file in samples, used if region only has fractions
+        @return int64
+    */
+    int64 getStartSample(int64 totalNumSamples);
+
+    /*! gets sample after the last sample of region, exact for sample accurate regions
+        @param int64 totalNumSamples: length of file in samples, used if region only has fractions
+        @return int64
+    */
+    int64 getEndSample(int64 totalNumSamples);
+
+    /*! gets sample rate of sample accurate regions
+        @return double: sample rate, 0 if region only has fractions
+    */
+    double getSampleRate();
+
+    /*! checks if region was created from samples rather than fractions
+        @return bool
+    */
+    bool isSampleAccurate();
+
+    /*! sets match scores from the similarity function, lower distances are better matches
+        @param float mean: mean distance over region
+        @param float min: min distance over region
+        @param float area: sum of distances over region blocks
+        @return void
+    */
+    void setScore(float mean, float min, float area);
+
+    /*! checks if region has match scores, regions added by hand don't
+        @return bool
+    */
+    bool hasScore();
+
+    float getMeanDistance();
+    float getMinDistance();
+    float getAreaDistance();
+
     /*! checks if fractional value is in region
         @param float: value as fraction
         @return bool
@@ -109,6 +156,15 @@ private:
     
     float startValue; // raw fractional start value of larger whole
     float endValue; // raw fractional end value of large whole
+
+    int64 startSample; // first sample, only valid when sampleRate is set
+    int64 endSample; // sample after last sample, only valid when sampleRate is set
+    double sampleRate; // 0 for regions that only have fractions
+
+    bool isScored; // whether scores below are set
+    float meanDistance; // mean of similarity function over region
+    float minDistance; // min of similarity function over region
+    float areaDistance; // sum of similarity function over region blocks
     
 };
 
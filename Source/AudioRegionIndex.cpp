@@ -0,0 +1,163 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "AudioRegionIndex.h"
+
+AudioRegionIndex::AudioRegionIndex(){
+}
+
+AudioRegionIndex::~AudioRegionIndex(){
+}
+
+void AudioRegionIndex::build(Array<AudioRegion>* regions){
+
+    clear();
+
+    int numRegions = regions->size();
+    entries.ensureStorageAllocated(numRegions);
+
+    for(int i=0; i<numRegions; i++){
+        AudioRegion region = (*regions)[i];
+
+        IndexEntry entry;
+        entry.start = region.getStart();
+        entry.end = region.getEnd();
+        entry.regionIdx = i;
+        entries.add(entry);
+    }
+
+    EntryComparator comparator;
+    entries.sort(comparator); // clustering already gives sorted regions, manual ones are added at the end
+
+    maxEnds.insertMultiple(0, 0.0f, numRegions);
+    buildMaxEnds(0, numRegions);
+}
+
+void AudioRegionIndex::clear(){
+    entries.clearQuick();
+    maxEnds.clearQuick();
+}
+
+int AudioRegionIndex::size(){
+    return entries.size();
+}
+
+float AudioRegionIndex::buildMaxEnds(int lo, int hi){
+
+    if(lo >= hi){
+        return -1.0f; // empty subtree
+    }
+
+    int mid = (lo + hi) / 2;
+    float maxEnd = jmax(entries.getReference(mid).end, buildMaxEnds(lo, mid), buildMaxEnds(mid + 1, hi));
+    maxEnds.set(mid, maxEnd);
+
+    return maxEnd;
+}
+
+void AudioRegionIndex::queryRange(int lo, int hi, float rangeStart, float rangeEnd, Array<int>* results){
+
+    if(lo >= hi){
+        return;
+    }
+
+    int mid = (lo + hi) / 2;
+    if(maxEnds.getUnchecked(mid) < rangeStart){ // everything in this subtree ends before the range
+        return;
+    }
+
+    queryRange(lo, mid, rangeStart, rangeEnd, results); // in order so results are sorted by start
+
+    const IndexEntry& entry = entries.getReference(mid);
+    if(entry.start > rangeEnd){ // this and everything to the right starts after the range
+        return;
+    }
+
+    if(entry.end >= rangeStart){
+        results->add(mid);
+    }
+
+    queryRange(mid + 1, hi, rangeStart, rangeEnd, results);
+}
+
+void AudioRegionIndex::findContaining(float value, Array<int>* results){
+
+    results->clearQuick();
+
+    Array<int> candidates;
+    queryRange(0, entries.size(), value, value, &candidates);
+
+    // candidates include regions with a boundary right on value, isInRegion doesn't count those
+    for(int i=0; i<candidates.size(); i++){
+        const IndexEntry& entry = entries.getReference(candidates[i]);
+        if(value > entry.start && value < entry.end){
+            results->add(entry.regionIdx);
+        }
+    }
+}
+
+void AudioRegionIndex::findInRange(float rangeStart, float rangeEnd, Array<int>* results){
+
+    results->clearQuick();
+
+    Array<int> candidates;
+    queryRange(0, entries.size(), rangeStart, rangeEnd, &candidates);
+
+    for(int i=0; i<candidates.size(); i++){
+        results->add(entries.getReference(candidates[i]).regionIdx);
+    }
+}
+
+void AudioRegionIndex::findOverlapping(AudioRegion region, Array<int>* results){
+
+    results->clearQuick();
+
+    float regionStart = region.getStart();
+    float regionEnd = region.getEnd();
+
+    Array<int> candidates;
+    queryRange(0, entries.size(), regionStart, regionEnd, &candidates);
+
+    // regions only touching at a boundary don't overlap
+    for(int i=0; i<candidates.size(); i++){
+        const IndexEntry& entry = entries.getReference(candidates[i]);
+        if(entry.start < regionEnd && entry.end > regionStart){
+            results->add(entry.regionIdx);
+        }
+    }
+}
+
+int AudioRegionIndex::findBoundaryNear(float value, float precision, bool* isStart){
+
+    Array<int> candidates;
+    queryRange(0, entries.size(), value - precision, value + precision, &candidates);
+
+    for(int i=0; i<candidates.size(); i++){
+        const IndexEntry& entry = entries.getReference(candidates[i]);
+
+        if(fabs(value - entry.start) < precision){
+            *isStart = true;
+            return entry.regionIdx;
+        }
+        else if(fabs(value - entry.end) < precision){
+            *isStart = false;
+            return entry.regionIdx;
+        }
+    }
+
+    return -1;
+}
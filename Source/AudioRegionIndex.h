@@ -0,0 +1,122 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef AUDIOREGIONINDEX_H_INCLUDED
+#define AUDIOREGIONINDEX_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+
+/*! sorted index over an array of regions for hit testing and overlap queries
+
+    Regions are sorted by start and treated as an implicit balanced binary tree (the middle of each range is the
+    node), where every node also keeps the max end of its subtree. That's an augmented interval tree, so point,
+    range and overlap queries are O(log n + k). Results are indices into the array the index was built from.
+*/
+class AudioRegionIndex
+{
+
+public:
+    AudioRegionIndex();
+    ~AudioRegionIndex();
+
+    /*! rebuilds the index, has to be called again whenever the regions change
+        @param Array<AudioRegion>* regions: regions to index
+        @return void
+    */
+    void build(Array<AudioRegion>* regions);
+
+    /*! removes all regions from the index
+        @return void
+    */
+    void clear();
+
+    /*! number of regions in the index
+        @return int
+    */
+    int size();
+
+    /*! finds regions containing a value, same rule as AudioRegion::isInRegion
+        @param float value: fractional value
+        @param Array<int>* results: indices of regions found, sorted by region start
+        @return void
+    */
+    void findContaining(float value, Array<int>* results);
+
+    /*! finds regions touching or crossing a range, ie the ones that need drawing for a visible range
+        @param float rangeStart: fractional value
+        @param float rangeEnd: fractional value
+        @param Array<int>* results: indices of regions found, sorted by region start
+        @return void
+    */
+    void findInRange(float rangeStart, float rangeEnd, Array<int>* results);
+
+    /*! finds regions overlapping the passed region, also finds regions containing it or contained by it
+        @param AudioRegion region
+        @param Array<int>* results: indices of regions found, sorted by region start
+        @return void
+    */
+    void findOverlapping(AudioRegion region, Array<int>* results);
+
+    /*! finds a region with its start or end near a value, for grabbing region boundaries with the mouse
+        @param float value: fractional value
+        @param float precision: max fractional distance from the boundary
+        @param bool* isStart: set true if the start is near, false if the end is near
+        @return int: index of region, -1 if none near
+    */
+    int findBoundaryNear(float value, float precision, bool* isStart);
+
+private:
+
+    struct IndexEntry{
+        float start;
+        float end;
+        int regionIdx; // index in the array the index was built from
+    };
+
+    struct EntryComparator{
+        static int compareElements(IndexEntry first, IndexEntry second){
+            if(first.start < second.start) return -1;
+            if(first.start > second.start) return 1;
+            return first.regionIdx - second.regionIdx; // keep array order for equal starts
+        }
+    };
+
+    /*! fills in max ends for the subtree over entries lo to hi
+        @param int lo: first entry
+        @param int hi: one past last entry
+        @return float: max end in the subtree
+    */
+    float buildMaxEnds(int lo, int hi);
+
+    /*! collects positions of entries that touch or cross the range from the subtree over entries lo to hi
+        @param int lo: first entry
+        @param int hi: one past last entry
+        @param float rangeStart
+        @param float rangeEnd
+        @param Array<int>* results: positions in entries, sorted by start
+        @return void
+    */
+    void queryRange(int lo, int hi, float rangeStart, float rangeEnd, Array<int>* results);
+
+    Array<IndexEntry> entries; // sorted by start
+    Array<float> maxEnds; // max end of the subtree rooted at each entry
+};
+
+
+
+#endif  // AUDIOREGIONINDEX_H_INCLUDED
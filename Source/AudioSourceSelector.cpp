@@ -45,7 +45,7 @@ AudioSourceSelector::AudioSourceSelector (int mode_)
 
     thumbComponent = new AudioThumbnail (1000, *thumbFormatManager, *thumbCache);
 
-    fileInputSource = nullptr;
+    segaudioFile = nullptr;
 
     mode = mode_ ;
 
@@ -54,8 +54,13 @@ AudioSourceSelector::AudioSourceSelector (int mode_)
 
     idxOfRegionHovered = 0;
     isRegionBeingEdited = false;
+    isHoveringOverRegionStart = false;
+    isHoveringOverRegionEnd = false;
     touchPrecision = 5;
 
+    regions = nullptr;
+    isRegionIndexValid = false;
+
     //[/Constructor]
 }
 
@@ -67,6 +72,10 @@ AudioSourceSelector::~AudioSourceSelector()
 
 
     //[Destructor]. You can add your own custom destruction code here..
+    if(segaudioFile != nullptr){
+        segaudioFile->removeListener(this); // before the thumbnail goes, the loader thread might be adding to it
+    }
+
     thumbFormatManager->clearFormats();
     delete thumbFormatManager;
     thumbFormatManager = nullptr;
@@ -121,43 +130,31 @@ void AudioSourceSelector::visibilityChanged()
 void AudioSourceSelector::mouseMove (const MouseEvent& e)
 {
     //[UserCode_mouseMove] -- Add your code here...
-    int numRegions = regions->size();
-    int mouseX = e.getPosition().getX();
-
-    // find region we might be hovering over, maybe better way to search?
-    for(int i=0; i<numRegions; i++){
-        float regionEnd = (*regions)[i].getEnd(getWidth());
-        float regionStart = (*regions)[i].getStart(getWidth());
+    rebuildRegionIndexIfNeeded();
 
-        if(fabs(mouseX - regionStart) < touchPrecision){  // near region start
+    float mouseFrac = float(e.getPosition().getX()) / getWidth();
+    float precisionFrac = float(touchPrecision) / getWidth();
 
-            MouseCursor cursor;
-            cursor = MouseCursor(MouseCursor::DraggingHandCursor);
-            setMouseCursor(cursor);
+    // find region boundary we might be hovering over
+    bool isNearStart = false;
+    int regionIdx = regionIndex.findBoundaryNear(mouseFrac, precisionFrac, &isNearStart);
 
-            isHoveringOverRegionStart = true;
-            idxOfRegionHovered = i;
-            break;
-        }
-        else if(fabs(mouseX - regionEnd) < touchPrecision){ // near region end
+    MouseCursor cursor;
+    if(regionIdx >= 0){ // near region start or end
 
-            MouseCursor cursor;
-            cursor = MouseCursor(MouseCursor::DraggingHandCursor);
-            setMouseCursor(cursor);
+        cursor = MouseCursor(MouseCursor::DraggingHandCursor);
 
-            isHoveringOverRegionEnd = true;
-            idxOfRegionHovered = i;
-            break;
-        }
-        else{  // not near region start or end
-            MouseCursor cursor;
-            cursor = MouseCursor(MouseCursor::NormalCursor);
-            setMouseCursor(cursor);
+        isHoveringOverRegionStart = isNearStart;
+        isHoveringOverRegionEnd = !isNearStart;
+        idxOfRegionHovered = regionIdx;
+    }
+    else{  // not near region start or end
+        cursor = MouseCursor(MouseCursor::NormalCursor);
 
-            isHoveringOverRegionEnd = false;
-            isHoveringOverRegionStart = false;
-        }
+        isHoveringOverRegionEnd = false;
+        isHoveringOverRegionStart = false;
     }
+    setMouseCursor(cursor);
 
     //[/UserCode_mouseMove]
 }
@@ -186,15 +183,16 @@ void AudioSourceSelector::mouseDown (const MouseEvent& e)
     }
 
     if(e.mods.isRightButtonDown()){  // delete regions with right click
-        int numRegions = regions->size();
+        rebuildRegionIndexIfNeeded();
+
         int mouseX = e.getPosition().getX();
+        Array<int> regionsClicked;
+        regionIndex.findContaining(float(mouseX) / getWidth(), &regionsClicked);
 
-        for(int i=0; i<numRegions; i++){
-            if((*regions)[i].isInRegion(float(mouseX) / getWidth())){
-                regions->remove(i);
-                sendActionMessage("numRegionsChanged");
-                break;
-            }
+        if(regionsClicked.size() > 0){
+            regions->remove(regionsClicked[0]);
+            isRegionIndexValid = false;
+            sendActionMessage("numRegionsChanged");
         }
     }
 
@@ -221,23 +219,24 @@ void AudioSourceSelector::mouseDrag (const MouseEvent& e)
             mouseDownX = tmp;
         }
         regions->set(0, AudioRegion(mouseDownX, endX, getWidth()));
+        isRegionIndexValid = false;
 
         sendActionMessage("srcRegionSelected");
     }
     else if(fileLoaded and mode == Target and isRegionBeingEdited){ // edit region if in target mode
-        float regionStart;
-        float regionEnd;
+        AudioRegion editedRegion = (*regions)[idxOfRegionHovered];
+        int64 regionStart = editedRegion.getStartSample(numSamples); // boundary not dragged keeps its exact sample
+        int64 regionEnd = editedRegion.getEndSample(numSamples);
 
         if(isHoveringOverRegionStart){
-            regionStart = float(dragX)/ getWidth();
-            regionEnd = (*regions)[idxOfRegionHovered].getEnd();
+            regionStart = getSampleFromPixel(dragX);
         }
         else if(isHoveringOverRegionEnd){
-            regionStart = (*regions)[idxOfRegionHovered].getStart();
-            regionEnd = float(dragX)/ getWidth();
+            regionEnd = getSampleFromPixel(dragX);
         }
 
-        regions->set(idxOfRegionHovered, AudioRegion(regionStart, regionEnd));
+        regions->set(idxOfRegionHovered, AudioRegion(regionStart, regionEnd, numSamples, sampleRate));
+        isRegionIndexValid = false;
     }
     else if(fileLoaded and mode==Target and isAddingRegion){
         int endX = mouseDownX + e.getDistanceFromDragStartX();
@@ -247,7 +246,8 @@ void AudioSourceSelector::mouseDrag (const MouseEvent& e)
             endX = mouseDownX;
             mouseDownX = tmp;
         }
-        regions->set(numRegions, AudioRegion(mouseDownX, endX, getWidth()));
+        regions->set(numRegions, AudioRegion(getSampleFromPixel(mouseDownX), getSampleFromPixel(endX), numSamples, sampleRate));
+        isRegionIndexValid = false;
         sendActionMessage("numRegionsChanged");
         DBG("test: numRegionsChanged");
     }
@@ -280,15 +280,21 @@ void AudioSourceSelector::setMode(int newMode) {
     mode = newMode;
 }
 
-void AudioSourceSelector::setFile(File &newFile){
+void AudioSourceSelector::setFile(SegaudioFile* newFile){
+
+    if(segaudioFile != nullptr){
+        segaudioFile->removeListener(this); // the loader thread mustn't add to the thumbnail while it's reset
+    }
+    segaudioFile = newFile;
 
-    fileInputSource = new FileInputSource(newFile);
-    thumbComponent->setSource(fileInputSource);
+    numChannels = segaudioFile->getNumChannels();
+    numSamples = segaudioFile->getNumSamples();
+    sampleRate = segaudioFile->getSampleRate();
 
-    ScopedPointer<AudioFormatReader> tmpReader = thumbFormatManager->createReaderFor(newFile);
-    numChannels = tmpReader->numChannels;
-    numSamples = tmpReader->lengthInSamples;
-    sampleRate = tmpReader->sampleRate;
+    // filled by samplesLoaded, no second reader. Switching back to a file that started loading, the blocks
+    // before now come from its decoded chunks
+    thumbComponent->reset(numChannels, sampleRate, numSamples);
+    segaudioFile->addListenerWithLoadedSamples(this);
 
     positionBarTimer = new PositionBarTimer(audioPositionFrac, numSamples, sampleRate);
 
@@ -297,6 +303,14 @@ void AudioSourceSelector::setFile(File &newFile){
     repaint();
 }
 
+void AudioSourceSelector::samplesLoaded(SegaudioFile* file, const AudioSampleBuffer &block, int64 startSample){
+    thumbComponent->addBlock(startSample, block, 0, block.getNumSamples()); // thread safe, repaints in drawWaveform
+}
+
+int64 AudioSourceSelector::getSampleFromPixel(int x){
+    return int64(double(x) / getWidth() * numSamples);
+}
+
 void AudioSourceSelector::drawWaveform(juce::Graphics &g){
     g.setColour(Colours::blue);
 
@@ -316,9 +330,25 @@ void AudioSourceSelector::drawWaveform(juce::Graphics &g){
 
 void AudioSourceSelector::setRegions(Array<AudioRegion>* regions_){
     regions = regions_;
+    isRegionIndexValid = false;
+    repaint();
+}
+
+void AudioSourceSelector::updateRegions(){
+    isRegionIndexValid = false;
     repaint();
 }
 
+void AudioSourceSelector::rebuildRegionIndexIfNeeded(){
+    if(regions == nullptr){
+        regionIndex.clear();
+    }
+    else if(!isRegionIndexValid){
+        regionIndex.build(regions);
+        isRegionIndexValid = true;
+    }
+}
+
 void AudioSourceSelector::drawCandidateRegions(juce::Graphics &g){
 
     if(mode == Reference){
@@ -329,10 +359,18 @@ void AudioSourceSelector::drawCandidateRegions(juce::Graphics &g){
     }
     g.setOpacity(0.5);
 
-    for(int i=0; i<regions->size(); i++){
+    // only draw regions in the visible part, the viewport only shows part of us when zoomed in
+    rebuildRegionIndexIfNeeded();
+
+    Rectangle<int> clipBounds = g.getClipBounds();
+    Array<int> visibleRegions;
+    regionIndex.findInRange(float(clipBounds.getX()) / getWidth(), float(clipBounds.getRight()) / getWidth(), &visibleRegions);
+
+    for(int i=0; i<visibleRegions.size(); i++){
 
-        int startX = (*regions)[i].getStart(getWidth());
-        int width = (*regions)[i].getEnd(getWidth()) - startX;
+        AudioRegion region = (*regions)[visibleRegions[i]];
+        int startX = region.getStart(getWidth());
+        int width = region.getEnd(getWidth()) - startX;
 
         g.fillRect(startX, 0, width, getHeight());
 
@@ -350,7 +388,7 @@ void AudioSourceSelector::drawAudioPositionBar(Graphics &g){
 }
 
 float AudioSourceSelector::getPositionBarTime(){
-    float currentPositionBarTime = audioPositionFrac * float(numSamples) / float(sampleRate);
+    float currentPositionBarTime = float(audioPositionFrac * double(numSamples) / sampleRate);
     return currentPositionBarTime;
 }
 
@@ -382,7 +420,7 @@ void AudioSourceSelector::stopPositionBar(){
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="AudioSourceSelector" componentName="audioSourceSelector"
-                 parentClasses="public Component, public ActionBroadcaster" constructorParams="int mode_"
+                 parentClasses="public Component, public ActionBroadcaster, public SegaudioFile::Listener" constructorParams="int mode_"
                  variableInitialisers="" snapPixels="8" snapActive="1" snapShown="1"
                  overlayOpacity="0.330" fixedSize="0" initialWidth="800" initialHeight="200">
   <METHODS>
@@ -24,6 +24,7 @@
 #include "JuceHeader.h"
 #include "AudioAnalysisController.h"
 #include "AudioRegion.h"
+#include "AudioRegionIndex.h"
 
 //[/Headers]
 
@@ -38,7 +39,8 @@
                                                                     //[/Comments]
 */
 class AudioSourceSelector  : public Component,
-                             public ActionBroadcaster
+                             public ActionBroadcaster,
+                             public SegaudioFile::Listener
 {
 public:
     //==============================================================================
@@ -64,11 +66,19 @@ public:
     */
     void setMode(int newMode);
 
-    /*! sets the file info for drawing
-        @param File &newFile
+    /*! sets the file info for drawing, the waveform is built from the blocks the file loads
+        @param SegaudioFile* newFile: file with info set, before it starts loading
         @return void
     */
-    void setFile(File &newFile);
+    void setFile(SegaudioFile* newFile);
+
+    /*! adds loaded samples to the waveform, called on the loader thread
+        @param SegaudioFile* file
+        @param const AudioSampleBuffer &block
+        @param int64 startSample
+        @return void
+    */
+    void samplesLoaded(SegaudioFile* file, const AudioSampleBuffer &block, int64 startSample);
 
     /*! draws the audio samples from the file
         @param Graphics &g
@@ -82,6 +92,11 @@ public:
     */
     void setRegions(Array<AudioRegion>* regions_);
 
+    /*! call when the regions were changed from outside, so the region index gets rebuilt
+        @return void
+    */
+    void updateRegions();
+
     /*! draws the regions for target mode
         @param Graphics &g
         @return void
@@ -147,14 +162,28 @@ private:
     float audioPositionFrac; // keeps fractional position of position bar
 
     int numChannels;
-    int numSamples;
-    int sampleRate;
+    int64 numSamples;
+    double sampleRate;
 
     Array<AudioRegion>* regions; // holds reference region in reference mode or candidate regions in target mode
 
+    AudioRegionIndex regionIndex; // sorted regions for hit testing, so we don't scan every region on mouse moves
+    bool isRegionIndexValid; // false when regions changed since the index was built
+
+    /*! converts a pixel position to a sample in the file, for sample accurate regions
+        @param int x: pixel position
+        @return int64
+    */
+    int64 getSampleFromPixel(int x);
+
+    /*! rebuilds the region index if the regions changed
+        @return void
+    */
+    void rebuildRegionIndexIfNeeded();
+
 //    AudioRegion regionToAdd;
 
-    FileInputSource* fileInputSource; // input source for file
+    SegaudioFile* segaudioFile; // file the waveform is from, listening to it while it loads
 
 
     // TODO: inherit Timer for AudioSourceSelector instead
@@ -162,7 +191,7 @@ private:
     {
     public:
 
-        PositionBarTimer(float &positionFraction, int numSamples, int sampleRate){
+        PositionBarTimer(float &positionFraction, int64 numSamples, double sampleRate){
             positionFrac = &positionFraction;
             totalSamples = numSamples;
             fileSampleRate = sampleRate;
@@ -182,8 +211,8 @@ private:
 
     private:
         float* positionFrac;
-        int totalSamples;
-        int fileSampleRate;
+        int64 totalSamples;
+        double fileSampleRate;
 
     };
 
@@ -0,0 +1,77 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "BatchExportPlan.h"
+
+BatchExportPlan::BatchExportPlan(){
+    numRegions = 0;
+}
+
+BatchExportPlan::~BatchExportPlan(){
+}
+
+void BatchExportPlan::addFile(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationFile){
+
+    PlannedFile* plannedFile = new PlannedFile();
+    plannedFile->sourceFile = sourceFile;
+    plannedFile->regions = regions;
+    plannedFile->destinationFile = destinationFile;
+
+    PathComparator comparator;
+    plannedFiles.addSorted(comparator, plannedFile); // next to files with the same path
+    numRegions += regions.size();
+}
+
+void BatchExportPlan::addFileToDirectory(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationDirectory, const String &extension){
+
+    // compared with the extension on, replacing it later would make "take.01" and "take.02" the same file
+    String name = sourceFile.getFileNameWithoutExtension();
+    File destinationFile = destinationDirectory.getChildFile(name + "." + extension);
+
+    for(int number=2; ; number++){
+        bool isNameUsed = false;
+        for(int i=0; i<plannedFiles.size() and not isNameUsed; i++){
+            isNameUsed = (plannedFiles[i]->destinationFile == destinationFile);
+        }
+        if(not isNameUsed){
+            break;
+        }
+        destinationFile = destinationDirectory.getChildFile(name + "_" + String(number) + "." + extension);
+    }
+
+    addFile(sourceFile, regions, destinationFile);
+}
+
+int BatchExportPlan::getNumFiles(){
+    return plannedFiles.size();
+}
+
+int BatchExportPlan::getNumRegions(){
+    return numRegions;
+}
+
+File BatchExportPlan::getSourceFile(int fileIdx){
+    return plannedFiles[fileIdx]->sourceFile;
+}
+
+const Array<AudioRegion>& BatchExportPlan::getRegions(int fileIdx){
+    return plannedFiles[fileIdx]->regions;
+}
+
+File BatchExportPlan::getDestinationFile(int fileIdx){
+    return plannedFiles[fileIdx]->destinationFile;
+}
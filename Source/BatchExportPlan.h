@@ -0,0 +1,110 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef BATCHEXPORTPLAN_H_INCLUDED
+#define BATCHEXPORTPLAN_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+
+/*! the source files and regions of one export, in the order they are read
+
+    Files are kept sorted by path, so files from the same folder are read one after another and the same file added
+    twice is read with one handle. Regions keep their order within a file, searches give them sorted by start.
+*/
+class BatchExportPlan
+{
+
+public:
+    BatchExportPlan();
+    ~BatchExportPlan();
+
+    /*! adds a file to export regions from
+        @param const File &sourceFile
+        @param const Array<AudioRegion> &regions: copied
+        @param const File &destinationFile: file to save to, or the name regions are saved next to
+        @return void
+    */
+    void addFile(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationFile);
+
+    /*! adds a file to export regions from into a folder, named after the file with the extension the files are
+        written with, so names with dots like "take.01" stay apart. Names already used by the plan get a number added,
+        for files with the same name from different folders
+        @param const File &sourceFile
+        @param const Array<AudioRegion> &regions: copied
+        @param const File &destinationDirectory
+        @param const String &extension: without the dot, "wav" for example
+        @return void
+    */
+    void addFileToDirectory(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationDirectory, const String &extension);
+
+    /*! gets the number of files added
+        @return int
+    */
+    int getNumFiles();
+
+    /*! gets the number of regions of all files
+        @return int
+    */
+    int getNumRegions();
+
+    /*! gets a file to read, in reading order
+        @param int fileIdx
+        @return File
+    */
+    File getSourceFile(int fileIdx);
+
+    /*! gets the regions of a file
+        @param int fileIdx
+        @return const Array<AudioRegion>&
+    */
+    const Array<AudioRegion>& getRegions(int fileIdx);
+
+    /*! gets where the regions of a file are saved
+        @param int fileIdx
+        @return File
+    */
+    File getDestinationFile(int fileIdx);
+
+private:
+
+    /*! one file to export from
+    */
+    struct PlannedFile{
+        File sourceFile;
+        Array<AudioRegion> regions;
+        File destinationFile;
+    };
+
+    /*! orders planned files by path
+    */
+    class PathComparator
+    {
+    public:
+        static int compareElements(PlannedFile* first, PlannedFile* second){
+            return first->sourceFile.getFullPathName().compare(second->sourceFile.getFullPathName());
+        }
+    };
+
+    OwnedArray<PlannedFile> plannedFiles;
+    int numRegions;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchExportPlan)
+};
+
+
+#endif  // BATCHEXPORTPLAN_H_INCLUDED
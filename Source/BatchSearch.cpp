@@ -0,0 +1,216 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "BatchSearch.h"
+
+
+BatchSearch::BatchSearch(const BatchSearchParameters &searchParams){
+    params = searchParams;
+    numFinished = 0;
+    numSucceeded = 0;
+    numFailed = 0;
+    shouldCancel = 0;
+}
+
+BatchSearch::~BatchSearch(){
+}
+
+void BatchSearch::addListener(Listener* listener){
+    const ScopedLock sl(listenerLock);
+    listeners.add(listener);
+}
+
+void BatchSearch::removeListener(Listener* listener){
+    const ScopedLock sl(listenerLock); // waits for a callback in progress
+    listeners.remove(listener);
+}
+
+void BatchSearch::addTarget(const File &targetFile){
+    String boundaryExtension = RegionBoundaryWriter::getFileExtension(params.boundaryFormat).substring(1);
+    plan.addFileToDirectory(targetFile, Array<AudioRegion>(), params.outputDirectory, boundaryExtension); // audio swaps the extension
+}
+
+int BatchSearch::addTargetsInDirectory(const File &directory, bool recursive){
+
+    AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    Array<File> targetFiles;
+    directory.findChildFiles(targetFiles, File::findFiles, recursive, formatManager.getWildcardForAllFormats());
+
+    for(int i=0; i<targetFiles.size(); i++){
+        addTarget(targetFiles[i]);
+    }
+    return targetFiles.size();
+}
+
+int BatchSearch::getNumTargets(){
+    return plan.getNumFiles();
+}
+
+bool BatchSearch::run(int numThreads){
+
+    numFinished = 0;
+    numSucceeded = 0;
+    numFailed = 0;
+    results.clear();
+    errorMessage = String::empty;
+
+    File reference = params.referenceFile;
+    SegaudioFile referenceFile;
+    referenceFile.setFile(reference);
+    if(not referenceFile.loadOnCallingThread() or referenceFile.getNumSamples() == 0){ // compressed files read as 0 until decoded
+        errorMessage = "Can't read reference " + reference.getFullPathName();
+        return false;
+    }
+
+    // seconds to samples, so the reference region is the same whatever the block size
+    int64 totalNumSamples = referenceFile.getNumSamples();
+    double sampleRate = referenceFile.getSampleRate();
+    int64 startSample = jlimit<int64>(0, totalNumSamples, int64(params.referenceStartSeconds * sampleRate));
+    int64 endSample = totalNumSamples;
+    if(params.referenceEndSeconds > 0){
+        endSample = jlimit<int64>(0, totalNumSamples, int64(params.referenceEndSeconds * sampleRate));
+    }
+    if(endSample <= startSample){
+        errorMessage = "Reference range is empty";
+        return false;
+    }
+    AudioRegion referenceRegion(startSample, endSample, totalNumSamples, sampleRate);
+
+    // the same for every target, so calculated once instead of by every job
+    SearchEngine referenceEngine(*this);
+    referenceFeatures = referenceEngine.calculateReferenceFeatures(&referenceFile, referenceRegion, &params.featuresToUse);
+
+    if(not params.outputDirectory.isDirectory() and not params.outputDirectory.createDirectory()){
+        errorMessage = "Can't create " + params.outputDirectory.getFullPathName();
+        return false;
+    }
+
+    int numTargets = plan.getNumFiles();
+    for(int i=0; i<numTargets; i++){
+        results.add(new TargetSearchResult());
+    }
+
+    if(numThreads <= 0){
+        numThreads = SystemStats::getNumCpus();
+    }
+
+    // each target is analysed on one core from start to end, so there is nothing to share between jobs
+    ThreadPool searchPool(jmax(1, jmin(numThreads, numTargets)));
+    for(int i=0; i<numTargets; i++){
+        searchPool.addJob(new SearchJob(*this, i), true);
+    }
+
+    while(numFinished.get() < numTargets){
+        if(isCancelled()){ // engines stop at their next block
+            searchPool.removeAllJobs(true, 10000);
+            break;
+        }
+        Thread::sleep(100);
+    }
+
+    return true;
+}
+
+void BatchSearch::cancel(){
+    shouldCancel = 1;
+}
+
+bool BatchSearch::isCancelled(){
+    return shouldCancel.get() != 0;
+}
+
+const TargetSearchResult& BatchSearch::getResult(int targetIdx){
+    return *results[targetIdx];
+}
+
+int BatchSearch::getNumSucceeded(){
+    return numSucceeded.get();
+}
+
+int BatchSearch::getNumFailed(){
+    return numFailed.get();
+}
+
+String BatchSearch::getErrorMessage(){
+    return errorMessage;
+}
+
+bool BatchSearch::searchTarget(int targetIdx, TargetSearchResult* result){
+
+    File targetPath = plan.getSourceFile(targetIdx);
+    SegaudioFile targetFile;
+    targetFile.setFile(targetPath);
+    if(not targetFile.loadOnCallingThread() or targetFile.getNumSamples() == 0){
+        result->errorMessage = "Can't read file";
+        return false;
+    }
+
+    // Step 1: similarity function, the same as for the target in the GUI
+    SearchEngine engine(*this);
+    Array<float> distanceArray;
+    float maxDistance = 0;
+    if(not engine.calculateTargetSimilarity(referenceFeatures, &targetFile, &params.featuresToUse, nullptr, &distanceArray, &maxDistance)){
+        result->errorMessage = "Cancelled";
+        return false;
+    }
+
+    DistanceStatistics distanceStatistics;
+    distanceStatistics.build(&distanceArray); // once, so scoring regions is O(1) each
+
+    // Step 2: regions, from the given cluster params or the ones a search found for this target
+    ClusterParameters clusterParams = params.clusterParams;
+    Array<AudioRegion> regions;
+    if(params.useSearch){
+        engine.findRegionsGridSearch(&params.searchParams, &distanceArray, &maxDistance, &clusterParams, &regions, &targetFile, &distanceStatistics);
+        if(params.searchParams.useWidthFilter){
+            clusterParams.minRegionTimeWidth = params.searchParams.minWidth;
+            clusterParams.maxRegionTimeWidth = params.searchParams.maxWidth;
+        }
+    }
+    engine.getClusterRegions(&clusterParams, &distanceArray, &maxDistance, &regions, &targetFile, &distanceStatistics);
+    result->numRegions = regions.size();
+
+    // Step 3: boundaries, then the audio
+    File destinationFile = plan.getDestinationFile(targetIdx);
+    File boundaryFile = destinationFile;
+    if(not RegionBoundaryWriter::writeRegions(&regions, boundaryFile, params.boundaryFormat, targetFile.getNumSamples(), targetFile.getSampleRate())){
+        result->errorMessage = "Can't write " + boundaryFile.getFullPathName();
+        return false;
+    }
+    result->boundaryFile = boundaryFile;
+
+    if(params.exportAudio and regions.size() > 0){
+        RegionExporter exporter(&targetFile, regions, destinationFile, params.exportParams.formatExtension);
+        exporter.setWritesOnCallingThread(true); // the search pool already has a job per core
+        if(params.exportParams.asOneFile){
+            exporter.exportToSingleFile(params.exportParams.gapSeconds, params.exportParams.crossfadeSeconds, nullptr);
+        }
+        else{
+            exporter.exportToSeparateFiles(nullptr);
+        }
+        result->numRegionsExported = exporter.getNumWritten();
+
+        if(exporter.getNumWritten() < regions.size()){
+            result->errorMessage = "Exported " + String(exporter.getNumWritten()) + " of " + String(regions.size()) + " regions";
+            return false;
+        }
+    }
+
+    return true;
+}
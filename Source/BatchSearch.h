@@ -0,0 +1,234 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef BATCHSEARCH_H_INCLUDED
+#define BATCHSEARCH_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+#include "SegaudioFile.h"
+#include "SegaudioModel.h"
+#include "AnalysisEngine.h"
+#include "RegionBoundaryWriter.h"
+#include "RegionExporter.h"
+#include "BatchExportPlan.h"
+
+//==============================================================================
+/*! what to search for in every target and where the results go
+
+*/
+struct BatchSearchParameters{
+    File referenceFile;
+    double referenceStartSeconds = 0;
+    double referenceEndSeconds = 0; // 0 for the end of the reference file
+    SignalFeaturesToUse featuresToUse;
+
+    ClusterParameters clusterParams; // used for every target unless searching
+    bool useSearch = false; // find the threshold for each target with searchParams instead
+    SearchParameters searchParams;
+
+    File outputDirectory; // boundaries and audio are named after each target
+    RegionBoundaryWriter::Format boundaryFormat = RegionBoundaryWriter::csv;
+    bool exportAudio = false;
+    ExportParameters exportParams; // used if exportAudio is set
+};
+
+/*! what searching one target gave
+
+*/
+struct TargetSearchResult{
+    File targetFile;
+    File boundaryFile; // empty until written
+    int numRegions = 0;
+    int numRegionsExported = 0;
+    bool succeeded = false;
+    String errorMessage; // why it didn't succeed
+};
+
+//==============================================================================
+/*
+    Searches many target files for one reference region without a GUI, for servers and the command line tool.
+
+    Targets are searched in parallel on a pool of threads, each with an AnalysisEngine of its own, against reference
+    features calculated once. Each target gets its boundaries file and, if asked, its audio in the output folder,
+    written on the thread that searched it. Targets are read sorted by path like a BatchExportPlan, which also gives files with the same name
+    from different folders different output names.
+*/
+class BatchSearch
+{
+
+public:
+
+    /*! gets told about each finished target
+    */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        /*! called on the search threads when a target is done, one call at a time
+            @param BatchSearch* search
+            @param const TargetSearchResult &result
+            @return void
+        */
+        virtual void targetSearched(BatchSearch* search, const TargetSearchResult &result) = 0;
+    };
+
+    /*! sets up the search
+        @param const BatchSearchParameters &params: copied
+    */
+    BatchSearch(const BatchSearchParameters &params);
+    ~BatchSearch();
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+    /*! adds a file to search, call before run
+        @param const File &targetFile
+        @return void
+    */
+    void addTarget(const File &targetFile);
+
+    /*! adds every file in a folder with an extension the registered audio formats read
+        @param const File &directory
+        @param bool recursive: include sub folders
+        @return int: number of files added
+    */
+    int addTargetsInDirectory(const File &directory, bool recursive);
+
+    /*! gets the number of targets added
+        @return int
+    */
+    int getNumTargets();
+
+    /*! searches all targets, returns when they are done or the search is cancelled
+        @param int numThreads: targets searched at once, 0 for one per core
+        @return bool: false if the reference couldn't be read, see getErrorMessage
+    */
+    bool run(int numThreads);
+
+    /*! stops a running search from any thread, targets being searched are finished as failed
+        @return void
+    */
+    void cancel();
+
+    /*! check if cancel was called
+        @return bool
+    */
+    bool isCancelled();
+
+    /*! gets the result of a target after run, in reading order
+        @param int targetIdx
+        @return const TargetSearchResult&
+    */
+    const TargetSearchResult& getResult(int targetIdx);
+
+    int getNumSucceeded();
+    int getNumFailed();
+
+    /*! gets why run returned false
+        @return String
+    */
+    String getErrorMessage();
+
+private:
+
+    BatchSearchParameters params;
+    BatchExportPlan plan; // targets in reading order with their output names, regions aren't used
+
+    Eigen::RowVectorXf referenceFeatures; // averaged features of the reference region, only read by the search threads
+
+    OwnedArray<TargetSearchResult> results; // one per target in the plan's order
+    String errorMessage;
+
+    Atomic<int> numFinished;
+    Atomic<int> numSucceeded;
+    Atomic<int> numFailed;
+    Atomic<int> shouldCancel;
+
+    ListenerList<Listener> listeners;
+    CriticalSection listenerLock; // one targetSearched call at a time
+
+    /*! calculates the similarity function of one target, finds its regions and writes them, called from the
+        search threads
+        @param int targetIdx
+        @param TargetSearchResult* result: filled in
+        @return bool: false if the target couldn't be read or written, or the search was cancelled
+    */
+    bool searchTarget(int targetIdx, TargetSearchResult* result);
+
+    /*! an AnalysisEngine that stops when the search is cancelled
+    */
+    class SearchEngine : public AnalysisEngine
+    {
+    public:
+        SearchEngine(BatchSearch &owner){
+            search = &owner;
+        };
+
+    protected:
+        bool isCalculationCancelled(){
+            return search->isCancelled();
+        }
+
+    private:
+        BatchSearch* search;
+    };
+
+    /*! searches one target
+    */
+    class SearchJob : public ThreadPoolJob
+    {
+    public:
+
+        SearchJob(BatchSearch &owner, int targetToSearch) : ThreadPoolJob("Segaudio Batch Search"){
+            search = &owner;
+            targetIdx = targetToSearch;
+        };
+
+        JobStatus runJob(){
+            TargetSearchResult* result = search->results[targetIdx];
+            result->targetFile = search->plan.getSourceFile(targetIdx);
+            result->succeeded = search->searchTarget(targetIdx, result);
+
+            if(result->succeeded){
+                ++search->numSucceeded;
+            }
+            else{
+                ++search->numFailed;
+            }
+
+            {
+                const ScopedLock sl(search->listenerLock);
+                search->listeners.call(&Listener::targetSearched, search, *result);
+            }
+
+            ++search->numFinished;
+            return jobHasFinished;
+        }
+
+    private:
+        BatchSearch* search;
+        int targetIdx;
+
+    };
+
+    JUCE_DECLARE_NON_COPYABLE (BatchSearch)
+};
+
+
+#endif  // BATCHSEARCH_H_INCLUDED
@@ -0,0 +1,86 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "CompactSampleBuffer.h"
+
+CompactSampleBuffer::CompactSampleBuffer(int numChannels_, int numSamples_, bool useInt16_){
+
+    numChannels = numChannels_;
+    numSamples = numSamples_;
+    useInt16 = useInt16_;
+
+    size_t numValues = size_t(numChannels) * size_t(numSamples);
+    if(useInt16){
+        int16Data.malloc(numValues);
+    }
+    else{
+        floatData.malloc(numValues);
+    }
+}
+
+CompactSampleBuffer::~CompactSampleBuffer(){
+}
+
+void CompactSampleBuffer::writeFrom(const AudioSampleBuffer &source, int numSamplesToWrite){
+
+    for(int j=0; j<numChannels; j++){
+        const float* src = source.getSampleData(j);
+
+        if(useInt16){
+            int16* dest = int16Data + size_t(j) * numSamples;
+            for(int i=0; i<numSamplesToWrite; i++){
+                float scaled = jlimit(-32768.0f, 32767.0f, src[i] * 32768.0f);
+                dest[i] = int16(scaled + (scaled >= 0 ? 0.5f : -0.5f)); // round, exact for 16 bit sources
+            }
+        }
+        else{
+            memcpy(floatData + size_t(j) * numSamples, src, sizeof(float) * size_t(numSamplesToWrite));
+        }
+    }
+}
+
+void CompactSampleBuffer::readInto(AudioSampleBuffer* destBuffer, int destChannel, int destStartSample, int sourceChannel, int sourceStartSample, int numSamplesToRead) const{
+
+    float* dest = destBuffer->getSampleData(destChannel, destStartSample);
+
+    if(useInt16){
+        const int16* src = int16Data + size_t(sourceChannel) * numSamples + sourceStartSample;
+        const float scale = 1.0f / 32768.0f;
+        for(int i=0; i<numSamplesToRead; i++){
+            dest[i] = src[i] * scale;
+        }
+    }
+    else{
+        memcpy(dest, floatData + size_t(sourceChannel) * numSamples + sourceStartSample, sizeof(float) * size_t(numSamplesToRead));
+    }
+}
+
+int CompactSampleBuffer::getNumChannels() const{
+    return numChannels;
+}
+
+int CompactSampleBuffer::getNumSamples() const{
+    return numSamples;
+}
+
+bool CompactSampleBuffer::isInt16() const{
+    return useInt16;
+}
+
+size_t CompactSampleBuffer::getSizeInBytes() const{
+    return size_t(numChannels) * size_t(numSamples) * (useInt16 ? sizeof(int16) : sizeof(float));
+}
@@ -0,0 +1,78 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef COMPACTSAMPLEBUFFER_H_INCLUDED
+#define COMPACTSAMPLEBUFFER_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*! holds decoded samples as 32 bit float or 16 bit int, int16 halves the memory and is exact for 16 bit sources
+
+    Samples go in and come out as float, the conversion loops are simple enough for the compiler to vectorize.
+*/
+class CompactSampleBuffer
+{
+
+public:
+    /*! allocates the samples, not cleared
+        @param int numChannels
+        @param int numSamples
+        @param bool useInt16: store as int16 instead of float
+    */
+    CompactSampleBuffer(int numChannels, int numSamples, bool useInt16);
+    ~CompactSampleBuffer();
+
+    /*! stores samples, converting if needed
+        @param const AudioSampleBuffer &source: needs at least as many channels as this buffer
+        @param int numSamplesToWrite: written from the start of both buffers
+        @return void
+    */
+    void writeFrom(const AudioSampleBuffer &source, int numSamplesToWrite);
+
+    /*! copies samples of one channel into a float buffer, converting if needed
+        @param AudioSampleBuffer* destBuffer
+        @param int destChannel
+        @param int destStartSample
+        @param int sourceChannel
+        @param int sourceStartSample
+        @param int numSamplesToRead
+        @return void
+    */
+    void readInto(AudioSampleBuffer* destBuffer, int destChannel, int destStartSample, int sourceChannel, int sourceStartSample, int numSamplesToRead) const;
+
+    int getNumChannels() const;
+    int getNumSamples() const;
+    bool isInt16() const;
+
+    /*! memory used by the samples
+        @return size_t
+    */
+    size_t getSizeInBytes() const;
+
+private:
+
+    int numChannels;
+    int numSamples;
+    bool useInt16;
+
+    HeapBlock<float> floatData; // numChannels * numSamples, channel after channel, empty if useInt16
+    HeapBlock<int16> int16Data; // same layout, empty if not useInt16
+};
+
+
+
+#endif  // COMPACTSAMPLEBUFFER_H_INCLUDED
@@ -270,6 +270,17 @@ ControlPanelComponent::ControlPanelComponent ()
     exportTxtButton->addListener (this);
     exportTxtButton->setColour (TextButton::buttonColourId, Colours::coral);
 
+    addAndMakeVisible (exportFormatComboBox = new ComboBox ("exportFormatComboBox"));
+    exportFormatComboBox->setTooltip ("Audio format of exported regions, the bit depth of the source is kept");
+    exportFormatComboBox->setEditableText (false);
+    exportFormatComboBox->setJustificationType (Justification::centredLeft);
+    exportFormatComboBox->setTextWhenNothingSelected ("WAV");
+    exportFormatComboBox->setTextWhenNoChoicesAvailable ("(no choices)");
+    exportFormatComboBox->addItem ("WAV", 1);
+    exportFormatComboBox->addItem ("FLAC", 2);
+    exportFormatComboBox->addItem ("Ogg", 3);
+    exportFormatComboBox->addListener (this);
+
 
     //[UserPreSize]
     //[/UserPreSize]
@@ -319,6 +330,7 @@ ControlPanelComponent::~ControlPanelComponent()
     searchButton = nullptr;
     widthFilterSearchToggle = nullptr;
     exportTxtButton = nullptr;
+    exportFormatComboBox = nullptr;
 
 
     //[Destructor]. You can add your own custom destruction code here..
@@ -385,6 +397,7 @@ void ControlPanelComponent::resized()
     searchButton->setBounds (24, proportionOfHeight (0.8425f), 96, 24);
     widthFilterSearchToggle->setBounds ((16) + 136, proportionOfHeight (0.7250f), 120, 24);
     exportTxtButton->setBounds ((24) + 152, proportionOfHeight (0.9125f), 104, 24);
+    exportFormatComboBox->setBounds ((24) + 152, proportionOfHeight (0.9525f), 104, 24);
     //[UserResized] Add your own custom resize handling here..
     //[/UserResized]
 }
@@ -534,6 +547,11 @@ void ControlPanelComponent::comboBoxChanged (ComboBox* comboBoxThatHasChanged)
         //[UserComboBoxCode_searchPercentComboBox] -- add your combo box handling code here..
         //[/UserComboBoxCode_searchPercentComboBox]
     }
+    else if (comboBoxThatHasChanged == exportFormatComboBox)
+    {
+        //[UserComboBoxCode_exportFormatComboBox] -- add your combo box handling code here..
+        //[/UserComboBoxCode_exportFormatComboBox]
+    }
 
     //[UsercomboBoxChanged_Post]
     //[/UsercomboBoxChanged_Post]
@@ -574,6 +592,9 @@ ExportParameters* ControlPanelComponent::getExportParameters(ExportParameters* e
 
     exportParams->asOneFile = saveSingleFileToggleButton->getToggleState();
 
+    const char* formatExtensions[] = {"wav", "flac", "ogg"}; // same order as exportFormatComboBox
+    exportParams->formatExtension = formatExtensions[jmax(0, exportFormatComboBox->getSelectedItemIndex())];
+
     return exportParams;
 }
 
@@ -628,6 +649,7 @@ void ControlPanelComponent::setExportEnabled(bool readyForExport) {
     exportSeparateButton->setEnabled(readyForExport);
     exportTxtButton->setEnabled(readyForExport);
     saveSingleFileToggleButton->setEnabled(readyForExport);
+    exportFormatComboBox->setEnabled(readyForExport);
 }
 
 void ControlPanelComponent::setSearchingEnabled(bool readyForSearching) {
@@ -801,6 +823,11 @@ BEGIN_JUCER_METADATA
               virtualName="" explicitFocusOrder="0" pos="152 91.191% 104 24"
               posRelativeX="a631088d4d356323" bgColOff="ffff7f50" buttonText="Export CSV"
               connectedEdges="0" needsCallback="1" radioGroupId="0"/>
+  <COMBOBOX name="exportFormatComboBox" id="3b7f0e2c91d84a56" memberName="exportFormatComboBox"
+            virtualName="" explicitFocusOrder="0" pos="152 95.285% 104 24"
+            posRelativeX="a631088d4d356323" tooltip="Audio format of exported regions, the bit depth of the source is kept"
+            editable="0" layout="33" items="WAV&#10;FLAC&#10;Ogg" textWhenNonSelected="WAV"
+            textWhenNoItems="(no choices)"/>
 </JUCER_COMPONENT>
 
 END_JUCER_METADATA
@@ -143,6 +143,7 @@ private:
     ScopedPointer<TextButton> searchButton;
     ScopedPointer<ToggleButton> widthFilterSearchToggle;
     ScopedPointer<TextButton> exportTxtButton;
+    ScopedPointer<ComboBox> exportFormatComboBox;
 
 
     //==============================================================================
@@ -0,0 +1,132 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "DistanceStatistics.h"
+
+DistanceStatistics::DistanceStatistics(){
+    numBlocks = 0;
+}
+
+DistanceStatistics::~DistanceStatistics(){
+}
+
+void DistanceStatistics::build(Array<float>* distanceArray){
+
+    clear();
+
+    numBlocks = distanceArray->size();
+    if(numBlocks == 0){
+        return;
+    }
+
+    // a nan or inf would spoil every range after it, those blocks count as the furthest away instead
+    float maxFiniteDistance = 0;
+    for(int i=0; i<numBlocks; i++){
+        if(juce_isfinite((*distanceArray)[i])){
+            maxFiniteDistance = jmax(maxFiniteDistance, (*distanceArray)[i]);
+        }
+    }
+
+    Array<float> distances;
+    distances.ensureStorageAllocated(numBlocks);
+    for(int i=0; i<numBlocks; i++){
+        distances.add(juce_isfinite((*distanceArray)[i]) ? (*distanceArray)[i] : maxFiniteDistance);
+    }
+
+    // prefix sums for area and mean
+    prefixSums.ensureStorageAllocated(numBlocks + 1);
+    prefixSums.add(0.0);
+    for(int i=0; i<numBlocks; i++){
+        prefixSums.add(prefixSums.getUnchecked(i) + distances.getUnchecked(i));
+    }
+
+    // log2 lookup for range lengths
+    log2Table.ensureStorageAllocated(numBlocks + 1);
+    log2Table.add(0); // length 0 not used
+    log2Table.add(0);
+    for(int i=2; i<=numBlocks; i++){
+        log2Table.add(log2Table.getUnchecked(i / 2) + 1);
+    }
+
+    // sparse table for min, level 0 is the distances themselves
+    int numLevels = log2Table.getUnchecked(numBlocks) + 1;
+    minTable.ensureStorageAllocated(numLevels * numBlocks);
+    for(int i=0; i<numBlocks; i++){
+        minTable.add(distances.getUnchecked(i));
+    }
+
+    for(int level=1; level<numLevels; level++){
+        int halfSpan = 1 << (level - 1);
+        int prevLevelStart = (level - 1) * numBlocks;
+
+        for(int i=0; i<numBlocks; i++){
+            if(i + halfSpan < numBlocks){
+                minTable.add(jmin(minTable.getUnchecked(prevLevelStart + i), minTable.getUnchecked(prevLevelStart + i + halfSpan)));
+            }
+            else{ // range runs past the end, never looked up
+                minTable.add(minTable.getUnchecked(prevLevelStart + i));
+            }
+        }
+    }
+}
+
+void DistanceStatistics::clear(){
+    numBlocks = 0;
+    prefixSums.clear();
+    minTable.clear();
+    log2Table.clear();
+}
+
+int DistanceStatistics::getNumBlocks(){
+    return numBlocks;
+}
+
+bool DistanceStatistics::limitRange(int &startBlock, int &endBlock){
+    startBlock = jlimit(0, numBlocks, startBlock);
+    endBlock = jlimit(0, numBlocks, endBlock);
+
+    if(endBlock <= startBlock){
+        return false;
+    }
+    return true;
+}
+
+double DistanceStatistics::getAreaDistance(int startBlock, int endBlock){
+    if(!limitRange(startBlock, endBlock)){
+        return 0.0;
+    }
+    return prefixSums.getUnchecked(endBlock) - prefixSums.getUnchecked(startBlock);
+}
+
+float DistanceStatistics::getMeanDistance(int startBlock, int endBlock){
+    if(!limitRange(startBlock, endBlock)){
+        return 0.0f;
+    }
+    return float(getAreaDistance(startBlock, endBlock) / (endBlock - startBlock));
+}
+
+float DistanceStatistics::getMinDistance(int startBlock, int endBlock){
+    if(!limitRange(startBlock, endBlock)){
+        return 0.0f;
+    }
+
+    // two power of two ranges covering the whole range, they may overlap which doesn't matter for min
+    int level = log2Table.getUnchecked(endBlock - startBlock);
+    int levelStart = level * numBlocks;
+
+    return jmin(minTable.getUnchecked(levelStart + startBlock), minTable.getUnchecked(levelStart + endBlock - (1 << level)));
+}
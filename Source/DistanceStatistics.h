@@ -0,0 +1,89 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef DISTANCESTATISTICS_H_INCLUDED
+#define DISTANCESTATISTICS_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*! range statistics over the similarity function, built once per distance array
+
+    Prefix sums give the area and mean of any block range in O(1). Prefix mins alone only answer ranges starting
+    at block 0, so the min uses a sparse table of mins over power of two ranges (two overlapping lookups per range).
+*/
+class DistanceStatistics
+{
+
+public:
+    DistanceStatistics();
+    ~DistanceStatistics();
+
+    /*! builds the tables, has to be called again whenever the distance array changes. Distances that aren't finite
+        count as the largest finite one
+        @param Array<float>* distanceArray: similarity function data points
+        @return void
+    */
+    void build(Array<float>* distanceArray);
+
+    /*! removes the tables
+        @return void
+    */
+    void clear();
+
+    /*! number of blocks the tables were built from
+        @return int
+    */
+    int getNumBlocks();
+
+    /*! sum of distances for blocks startBlock up to (not including) endBlock
+        @param int startBlock
+        @param int endBlock
+        @return double: area under similarity function in distance * blocks
+    */
+    double getAreaDistance(int startBlock, int endBlock);
+
+    /*! mean distance for blocks startBlock up to (not including) endBlock
+        @param int startBlock
+        @param int endBlock
+        @return float: mean, 0 for empty range
+    */
+    float getMeanDistance(int startBlock, int endBlock);
+
+    /*! min distance for blocks startBlock up to (not including) endBlock
+        @param int startBlock
+        @param int endBlock
+        @return float: min, 0 for empty range
+    */
+    float getMinDistance(int startBlock, int endBlock);
+
+private:
+
+    /*! clamps a block range to the built tables
+        @return bool: false if the range is empty
+    */
+    bool limitRange(int &startBlock, int &endBlock);
+
+    int numBlocks;
+
+    Array<double> prefixSums; // prefixSums[i] is the sum of the first i distances, double so long files don't drift
+    Array<float> minTable; // level k holds mins of 2^k blocks starting at each block, levels stored one after the other
+    Array<int> log2Table; // floor(log2(i)) for range lengths
+};
+
+
+
+#endif  // DISTANCESTATISTICS_H_INCLUDED
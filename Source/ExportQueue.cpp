@@ -0,0 +1,199 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "ExportQueue.h"
+
+ExportQueue::ExportQueue() : Thread("Segaudio Export Queue"){
+    currentExporter = nullptr;
+    progress = 0;
+    startThread();
+}
+
+ExportQueue::~ExportQueue(){
+    cancelAllExports();
+    signalThreadShouldExit();
+    notify(); // waiting for exports
+    stopThread(10000);
+}
+
+void ExportQueue::run(){
+
+    while(not threadShouldExit()){
+
+        ExportTask* task = nullptr;
+        {
+            const ScopedLock lock(queueLock);
+            if(pendingExports.size() > 0){
+                task = currentTask = pendingExports.removeAndReturn(0);
+            }
+        }
+
+        if(task == nullptr){
+            wait(-1); // woken by addExport
+            continue;
+        }
+
+        BatchExportPlan* plan = task->plan;
+        {
+            const ScopedLock lock(queueLock);
+            progress = 0;
+            status = "Exporting " + String(plan->getNumRegions()) + " regions";
+            if(plan->getNumFiles() > 1){
+                status += " from " + String(plan->getNumFiles()) + " files to " + plan->getDestinationFile(0).getParentDirectory().getFileName();
+            }
+            else if(plan->getNumFiles() == 1){
+                status += " to " + plan->getDestinationFile(0).getFileName();
+            }
+            if(pendingExports.size() > 0){
+                status += " (" + String(pendingExports.size()) + " more queued)";
+            }
+        }
+        sendActionMessage("exportStarted");
+
+        ExportSummary summary;
+        summary.destinationFile = plan->getDestinationFile(0);
+        summary.numRegions = plan->getNumRegions();
+        double startTime = Time::getMillisecondCounterHiRes();
+
+        // opened again, the app's files can be replaced while this one exports. Files follow each other in path
+        // order, so the same file is only opened once
+        ScopedPointer<SegaudioFile> sourceFile;
+        int numRegionsBefore = 0;
+
+        for(int i=0; i<plan->getNumFiles() and not summary.wasCancelled; i++){
+            if(sourceFile == nullptr or sourceFile->getFile() != plan->getSourceFile(i)){
+                File fileToOpen = plan->getSourceFile(i);
+                sourceFile = new SegaudioFile();
+                sourceFile->setFile(fileToOpen);
+            }
+
+            const Array<AudioRegion>& regions = plan->getRegions(i);
+            RegionExporter exporter(sourceFile, regions, plan->getDestinationFile(i), task->formatExtension);
+            exporter.setProgressRange(double(numRegionsBefore) / jmax(1, plan->getNumRegions()), double(regions.size()) / jmax(1, plan->getNumRegions()));
+            {
+                const ScopedLock lock(queueLock);
+                currentExporter = &exporter;
+                if(task->isCancelled){ // cancelled between two files
+                    exporter.cancel();
+                }
+            }
+
+            if(task->useSingleFile){
+                exporter.exportToSingleFile(task->gapSeconds, task->crossfadeSeconds, &progress);
+            }
+            else{
+                exporter.exportToSeparateFiles(&progress);
+            }
+
+            {
+                const ScopedLock lock(queueLock);
+                currentExporter = nullptr; // the exporter goes out of scope next
+            }
+
+            summary.numWritten += exporter.getNumWritten();
+            summary.numBytes += exporter.getNumBytesWritten();
+            summary.wasCancelled = exporter.isCancelled();
+            numRegionsBefore += regions.size();
+        }
+
+        summary.elapsedSeconds = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        {
+            const ScopedLock lock(queueLock);
+            currentTask = nullptr;
+            lastSummary = summary;
+        }
+        sendActionMessage(summary.wasCancelled ? "exportCancelled" : "regionsExported");
+    }
+}
+
+void ExportQueue::addExport(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationFile, bool useSingleFile, String formatExtension, double gapSeconds, double crossfadeSeconds){
+
+    BatchExportPlan* plan = new BatchExportPlan();
+    plan->addFile(sourceFile, regions, destinationFile);
+    addBatchExport(plan, useSingleFile, formatExtension, gapSeconds, crossfadeSeconds);
+}
+
+void ExportQueue::addBatchExport(BatchExportPlan* plan, bool useSingleFile, String formatExtension, double gapSeconds, double crossfadeSeconds){
+
+    ExportTask* task = new ExportTask();
+    task->plan = plan;
+    task->useSingleFile = useSingleFile;
+    task->formatExtension = formatExtension;
+    task->gapSeconds = gapSeconds;
+    task->crossfadeSeconds = crossfadeSeconds;
+    task->isCancelled = false;
+
+    if(plan->getNumFiles() == 0){ // nothing to report either
+        delete task;
+        return;
+    }
+
+    {
+        const ScopedLock lock(queueLock);
+        pendingExports.add(task);
+    }
+    notify();
+}
+
+void ExportQueue::cancelCurrentExport(){
+    const ScopedLock lock(queueLock);
+    if(currentTask != nullptr){
+        currentTask->isCancelled = true; // the rest of its files
+    }
+    if(currentExporter != nullptr){
+        currentExporter->cancel();
+    }
+}
+
+void ExportQueue::cancelAllExports(){
+    const ScopedLock lock(queueLock);
+    pendingExports.clear();
+    if(currentTask != nullptr){
+        currentTask->isCancelled = true;
+    }
+    if(currentExporter != nullptr){
+        currentExporter->cancel();
+    }
+}
+
+int ExportQueue::getNumExports(){
+    const ScopedLock lock(queueLock);
+    return pendingExports.size() + (currentTask != nullptr ? 1 : 0);
+}
+
+double& ExportQueue::getProgress(){
+    return progress;
+}
+
+String ExportQueue::getStatus(){
+    const ScopedLock lock(queueLock);
+    return status;
+}
+
+ExportSummary ExportQueue::getLastSummary(){
+    const ScopedLock lock(queueLock);
+    return lastSummary;
+}
+
+String ExportQueue::getSummaryText(const ExportSummary &summary){
+
+    String summaryText = summary.wasCancelled ? "Export cancelled, " : "Exported ";
+    summaryText += String(summary.numWritten) + " of " + String(summary.numRegions) + " regions, ";
+    summaryText += File::descriptionOfSizeInBytes(summary.numBytes) + " in " + String(summary.elapsedSeconds, 1) + " s";
+    return summaryText;
+}
@@ -0,0 +1,139 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef EXPORTQUEUE_H_INCLUDED
+#define EXPORTQUEUE_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+#include "SegaudioFile.h"
+#include "RegionExporter.h"
+#include "BatchExportPlan.h"
+
+/*! what an export wrote, for the report after it's done
+*/
+struct ExportSummary{
+    File destinationFile; // of the first file for batch exports
+    int numRegions = 0;
+    int numWritten = 0; // less than numRegions if cancelled or some failed
+    int64 numBytes = 0;
+    double elapsedSeconds = 0;
+    bool wasCancelled = false;
+};
+
+/*! runs region exports one after another on its own thread, so searching goes on while files are written
+
+    Every export opens its source files again when it starts, so loading other files into the app meanwhile doesn't
+    change what's exported. A batch export reads its files in the plan's order, one after another, each exported on
+    the export threads. Sends "exportStarted" when an export begins and "regionsExported" or "exportCancelled"
+    when it ends, getLastSummary then has its numbers.
+*/
+class ExportQueue : public Thread,
+                    public ActionBroadcaster
+{
+
+public:
+    ExportQueue();
+    ~ExportQueue();
+
+    void run();
+
+    /*! queues an export, it starts once the ones before it are done
+        @param const File &sourceFile: file the regions are from
+        @param const Array<AudioRegion> &regions: copied
+        @param const File &destinationFile: file to save to, or the name regions are saved next to
+        @param bool useSingleFile: all regions into one file or every region to its own
+        @param String formatExtension: "wav", "flac" or "ogg"
+        @param double gapSeconds: silence between regions in a single file
+        @param double crossfadeSeconds: overlap between regions in a single file, if there's no gap
+        @return void
+    */
+    void addExport(const File &sourceFile, const Array<AudioRegion> &regions, const File &destinationFile, bool useSingleFile, String formatExtension, double gapSeconds, double crossfadeSeconds);
+
+    /*! queues exporting the regions of many files as one export, with one progress and one report
+        @param BatchExportPlan* plan: deleted by the queue
+        @param bool useSingleFile: all regions of a file into one file or every region to its own
+        @param String formatExtension: "wav", "flac" or "ogg"
+        @param double gapSeconds: silence between regions in a single file
+        @param double crossfadeSeconds: overlap between regions in a single file, if there's no gap
+        @return void
+    */
+    void addBatchExport(BatchExportPlan* plan, bool useSingleFile, String formatExtension, double gapSeconds, double crossfadeSeconds);
+
+    /*! stops the running export, the rest of its files included, the next one in the queue starts
+        @return void
+    */
+    void cancelCurrentExport();
+
+    /*! stops the running export and drops the queued ones
+        @return void
+    */
+    void cancelAllExports();
+
+    /*! gets the exports not done yet, the running one included
+        @return int
+    */
+    int getNumExports();
+
+    /*! gets the progress of the running export, for a ProgressBar
+        @return double&: 0 to 1
+    */
+    double& getProgress();
+
+    /*! describes the running export
+        @return String
+    */
+    String getStatus();
+
+    /*! gets the numbers of the last export that ended
+        @return ExportSummary
+    */
+    ExportSummary getLastSummary();
+
+    /*! describes an export that ended, regions, bytes and time
+        @param const ExportSummary &summary
+        @return String
+    */
+    static String getSummaryText(const ExportSummary &summary);
+
+private:
+
+    /*! an export waiting in the queue
+    */
+    struct ExportTask{
+        ScopedPointer<BatchExportPlan> plan;
+        bool useSingleFile;
+        String formatExtension;
+        double gapSeconds;
+        double crossfadeSeconds;
+        bool isCancelled; // guarded by queueLock
+    };
+
+    OwnedArray<ExportTask> pendingExports;
+    ScopedPointer<ExportTask> currentTask; // set from taking it off the queue until its summary is in, guarded by queueLock
+    RegionExporter* currentExporter; // only set while an export runs, guarded by queueLock
+    CriticalSection queueLock;
+
+    double progress;
+    String status;
+    ExportSummary lastSummary;
+
+    JUCE_DECLARE_NON_COPYABLE (ExportQueue)
+};
+
+
+#endif  // EXPORTQUEUE_H_INCLUDED
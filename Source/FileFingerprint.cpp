@@ -0,0 +1,137 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "FileFingerprint.h"
+
+namespace
+{
+    const uint64 prime1 = 11400714785074694791ULL;
+    const uint64 prime2 = 14029467366897019727ULL;
+    const uint64 prime3 = 1609587929392839161ULL;
+    const uint64 prime4 = 9650029242287828579ULL;
+    const uint64 prime5 = 2870177450012600261ULL;
+
+    inline uint64 rotateLeft(uint64 value, int bits){
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    inline uint64 read64(const uint8* bytes){
+        uint64 value;
+        memcpy(&value, bytes, sizeof(value)); // unaligned
+        return ByteOrder::swapIfBigEndian(value);
+    }
+
+    inline uint32 read32(const uint8* bytes){
+        uint32 value;
+        memcpy(&value, bytes, sizeof(value));
+        return ByteOrder::swapIfBigEndian(value);
+    }
+
+    inline uint64 mixRound(uint64 acc, uint64 input){
+        acc += input * prime2;
+        acc = rotateLeft(acc, 31);
+        return acc * prime1;
+    }
+
+    inline uint64 mergeRound(uint64 acc, uint64 value){
+        acc ^= mixRound(0, value);
+        return acc * prime1 + prime4;
+    }
+}
+
+uint64 FileFingerprint::calculate(const File &file){
+
+    FileInputStream stream(file);
+    if(stream.failedToOpen()){
+        return 0;
+    }
+
+    int64 fileSize = stream.getTotalLength();
+    MemoryBlock sampledBytes;
+
+    // the header, then chunks spread over the rest
+    MemoryBlock chunk(headerBytes);
+    int numRead = stream.read(chunk.getData(), headerBytes);
+    sampledBytes.append(chunk.getData(), size_t(jmax(0, numRead)));
+
+    int64 restSize = fileSize - headerBytes;
+    for(int i=0; i<numSampledChunks and restSize > 0; i++){
+        int64 chunkStart = headerBytes + restSize * i / numSampledChunks;
+        if(not stream.setPosition(chunkStart)){
+            return 0;
+        }
+        numRead = stream.read(chunk.getData(), sampledChunkBytes);
+        sampledBytes.append(chunk.getData(), size_t(jmax(0, numRead)));
+    }
+
+    return xxHash64(sampledBytes.getData(), sampledBytes.getSize(), uint64(fileSize));
+}
+
+uint64 FileFingerprint::xxHash64(const void* data, size_t numBytes, uint64 seed){
+
+    const uint8* bytes = static_cast<const uint8*>(data);
+    const uint8* end = bytes + numBytes;
+    uint64 hash;
+
+    if(numBytes >= 32){ // four lanes of 8 bytes
+        uint64 v1 = seed + prime1 + prime2;
+        uint64 v2 = seed + prime2;
+        uint64 v3 = seed;
+        uint64 v4 = seed - prime1;
+
+        for(; bytes + 32 <= end; bytes += 32){
+            v1 = mixRound(v1, read64(bytes));
+            v2 = mixRound(v2, read64(bytes + 8));
+            v3 = mixRound(v3, read64(bytes + 16));
+            v4 = mixRound(v4, read64(bytes + 24));
+        }
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else{
+        hash = seed + prime5;
+    }
+
+    hash += uint64(numBytes);
+
+    for(; bytes + 8 <= end; bytes += 8){
+        hash ^= mixRound(0, read64(bytes));
+        hash = rotateLeft(hash, 27) * prime1 + prime4;
+    }
+    if(bytes + 4 <= end){
+        hash ^= uint64(read32(bytes)) * prime1;
+        hash = rotateLeft(hash, 23) * prime2 + prime3;
+        bytes += 4;
+    }
+    for(; bytes < end; bytes++){
+        hash ^= uint64(*bytes) * prime5;
+        hash = rotateLeft(hash, 11) * prime1;
+    }
+
+    // avalanche
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
@@ -0,0 +1,54 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef FILEFINGERPRINT_H_INCLUDED
+#define FILEFINGERPRINT_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*! content hash of an audio file, stays the same when the file is renamed or moved, for keying caches
+
+    Hashes the header and evenly spaced chunks of the file with XXH64 instead of every byte, so it costs a few
+    small reads no matter how long the file is. The file size goes in as the seed, so edits that change the length
+    always change the hash. Edits that only touch bytes between the sampled chunks aren't noticed.
+*/
+class FileFingerprint
+{
+
+public:
+    /*! hashes the header and sampled chunks of a file
+        @param const File &file
+        @return uint64: 0 if the file can't be read
+    */
+    static uint64 calculate(const File &file);
+
+    /*! XXH64 of a block of memory
+        @param const void* data
+        @param size_t numBytes
+        @param uint64 seed
+        @return uint64
+    */
+    static uint64 xxHash64(const void* data, size_t numBytes, uint64 seed);
+
+private:
+    static const int headerBytes = 65536; // covers the format header and the first samples
+    static const int numSampledChunks = 16;
+    static const int sampledChunkBytes = 4096;
+};
+
+
+#endif  // FILEFINGERPRINT_H_INCLUDED
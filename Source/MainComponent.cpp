@@ -52,12 +52,14 @@ MainComponent::MainComponent (AudioAnalysisController &analysisController)
     referenceFileComponent->addActionListener(this);
     targetFileComponent->addActionListener(this);
     controlPanelComponent->addActionListener(this);
+    this->analysisController->addActionListener(this); // similarity results come back from the worker thread
 
     isRefFileLoaded = false;
     isTargetFileLoaded = false;
     isRegionSelected = false;
 
     appModel = new SegaudioModel(2);
+    appModel->setMemoryBudget(size_t(SystemStats::getMemorySizeInMegabytes()) * 1024 * 1024 / 4); // a quarter of the RAM for decoded samples
 
     targetFileComponent->setRegions(appModel->getTargetRegions());
     referenceFileComponent->setRegions(appModel->getReferenceRegions());
@@ -80,12 +82,20 @@ MainComponent::MainComponent (AudioAnalysisController &analysisController)
     String result = deviceManager.setAudioDeviceSetup (deviceConfig, true);
 
     TooltipWindow(tooltipWindow);
+
+    // exports run in the background, this only shows up while they do and for their report
+    addChildComponent(exportProgressBar = new ProgressBar(this->analysisController->getExportQueue()->getProgress()));
+    addChildComponent(exportCancelButton = new TextButton("exportCancelButton"));
+    exportCancelButton->setButtonText("Cancel");
+    exportCancelButton->addListener(this);
     //[/Constructor]
 }
 
 MainComponent::~MainComponent()
 {
     //[Destructor_pre]. You can add your own custom destruction code here..
+    exportProgressBar = nullptr;
+    exportCancelButton = nullptr;
     //[/Destructor_pre]
 
     referenceFileComponent = nullptr;
@@ -117,6 +127,8 @@ void MainComponent::resized()
     targetFileComponent->setBounds ((0) + (300), proportionOfHeight (0.3673f), getWidth() - 300, proportionOfHeight (0.6352f));
     controlPanelComponent->setBounds (0, 0, 300, proportionOfHeight (1.0000f));
     //[UserResized] Add your own custom resize handling here..
+    exportProgressBar->setBounds(getWidth() - 500, getHeight() - 32, 400, 24);
+    exportCancelButton->setBounds(getWidth() - 92, getHeight() - 32, 80, 24);
     //[/UserResized]
 }
 
@@ -127,7 +139,7 @@ void MainComponent::actionListenerCallback(const juce::String &message){
 
     if(message.contains("setReferenceFile")){
 
-        appModel->clearTargetRegions();
+        appModel->clearAllTargetRegions(); // every target was compared to the old reference
         targetFileComponent->clearSimilarity();
 
         appModel->addFile(referenceFileComponent->getLoadedFile(), "0");
@@ -138,16 +150,47 @@ void MainComponent::actionListenerCallback(const juce::String &message){
 
     }
     else if(message.contains("setTargetFile")){
-        appModel->clearTargetRegions();
         targetFileComponent->clearSimilarity();
 
+        // the loaded file is target "1", the other picked files are loaded by the model
+        pendingTargetIds.clear();
+        appModel->removeTargets();
         appModel->addFile(targetFileComponent->getLoadedFile(), "1");
+
+        Array<File> selectedFiles = targetFileComponent->getSelectedFiles();
+        for(int i=1; i<selectedFiles.size(); i++){
+            SegaudioFile* targetFile = appModel->addTargetFile(selectedFiles.getReference(i));
+            targetFile->addActionListener(this); // "fileLoaded"
+            targetFile->startLoading();
+        }
+
+        StringArray targetNames;
+        StringArray targetIds = appModel->getTargetIds();
+        for(int i=0; i<targetIds.size(); i++){
+            targetNames.add(appModel->getSegaudioFile(targetIds[i])->getFile().getFileName());
+        }
+        targetFileComponent->setTargetNames(targetNames);
+
+        appModel->setActiveTarget("1");
         isTargetFileLoaded = true;
         controlPanelComponent->setCalcEnabled(isReadyToCompare());
 
         newRegionsUpdate();
 
     }
+    else if(message == "referenceFileLoaded" or message == "targetFileLoaded" or message == "fileLoaded"){
+        controlPanelComponent->setCalcEnabled(isReadyToCompare()); // analysis needs all samples decoded
+    }
+    else if(message == "targetSelected"){
+        String targetId = appModel->getTargetIds()[targetFileComponent->getSelectedTargetIndex()];
+        if(appModel->setActiveTarget(targetId)){
+            showActiveTarget();
+
+            bool isCalculated = appModel->getDistanceArray()->size() > 0;
+            controlPanelComponent->setFindRegionsEnabled(isCalculated);
+            controlPanelComponent->setSearchingEnabled(isCalculated);
+        }
+    }
     else if(message == "srcRegionSelected"){
         isRegionSelected = true;
         targetFileComponent->clearSimilarity();
@@ -157,10 +200,53 @@ void MainComponent::actionListenerCallback(const juce::String &message){
     else if(message == "calculateSimilarity"){
 
         targetFileComponent->clearSimilarity();
-        analysisController->calculateDistances(appModel->getDistanceArray(), appModel->getMaxDistance(), appModel->getFileBuffer("0"), appModel->getFileBuffer("1"), appModel->getReferenceRegions(), controlPanelComponent->getSignalFeaturesToUse(appModel->getSignalFeaturesToUse()));
-        controlPanelComponent->setFindRegionsEnabled(true);
-        controlPanelComponent->setSearchingEnabled(true);
 
+        // regions show up while the target is analysed, replaced by the full pass once it's done
+        appModel->clearAllTargetRegions();
+        targetFileComponent->updateRegions();
+
+        // the reference region or features may have changed since the last run, they're calculated once for all targets
+        analysisController->clearReferenceFeatures();
+
+        // the active target first, so its results show up before the rest
+        pendingTargetIds = appModel->getTargetIds();
+        pendingTargetIds.removeString(appModel->getActiveTargetId());
+        pendingTargetIds.insert(0, appModel->getActiveTargetId());
+
+        calculateNextTarget();
+        // results come back with "similarityCalculated" when the worker thread is done with each target
+    }
+    else if(message == "onlineRegionsFound"){
+        TargetAnalysis* target = appModel->getTarget(calculatingTargetId);
+        if(target != nullptr and analysisController->takeOnlineRegions(&target->regions) > 0 and target->id == appModel->getActiveTargetId()){
+            targetFileComponent->updateRegions();
+            targetFileComponent->repaint();
+            controlPanelComponent->newRegionsUpdate(appModel->getTargetRegions());
+        }
+    }
+    else if(message == "similarityCalculated"){
+        TargetAnalysis* target = appModel->getTarget(calculatingTargetId);
+        if(target != nullptr){
+            target->distanceStatistics.build(&target->distanceArray); // once, so scoring regions is O(1) each
+            analysisController->getClusterRegions(controlPanelComponent->getClusterParams(), &target->distanceArray, &target->maxDistance, &target->regions, target->file, &target->distanceStatistics);
+        }
+
+        if(target != nullptr and target->id == appModel->getActiveTargetId()){
+            controlPanelComponent->setFindRegionsEnabled(true);
+            controlPanelComponent->setSearchingEnabled(true);
+
+            newRegionsUpdate();
+        }
+
+        calculateNextTarget();
+    }
+    else if(message == "similarityCancelled"){
+        pendingTargetIds.clear();
+
+        TargetAnalysis* target = appModel->getTarget(calculatingTargetId);
+        if(target != nullptr){
+            target->distanceStatistics.clear();
+        }
         newRegionsUpdate();
     }
     else if(message == "clusterParamsChanged"){
@@ -173,7 +259,7 @@ void MainComponent::actionListenerCallback(const juce::String &message){
         controlPanelComponent->getSearchParameters(appModel->getSearchParameters());
 
 //        analysisController->findRegionsBinarySearch(appModel->getSearchParameters(), appModel->getDistanceArray(), appModel->getClusterParams(), appModel->getTargetRegions());
-        analysisController->findRegionsGridSearch(appModel->getSearchParameters(), appModel->getDistanceArray(), appModel->getMaxDistance(), appModel->getClusterParams(), appModel->getTargetRegions());
+        analysisController->findRegionsGridSearch(appModel->getSearchParameters(), appModel->getDistanceArray(), appModel->getMaxDistance(), appModel->getClusterParams(), appModel->getTargetRegions(), appModel->getSegaudioFile(appModel->getActiveTargetId()), appModel->getDistanceStatistics());
 
         // set found params on control panel
         controlPanelComponent->setClusterParams(appModel->getClusterParams());
@@ -184,32 +270,70 @@ void MainComponent::actionListenerCallback(const juce::String &message){
 
         ExportParameters* exportParams = appModel->getExportParameters();
         controlPanelComponent->getExportParameters(exportParams);
-        String prompt = "Saving " + String(appModel->getTargetRegions()->size()) + " regions";
-        if(exportParams->asOneFile){
-            prompt += " as one file...";
+
+        // matches in several targets are exported together, in one pass over the files
+        StringArray targetIds = appModel->getTargetIds();
+        Array<TargetAnalysis*> targetsWithRegions;
+        for(int i=0; i<targetIds.size(); i++){
+            TargetAnalysis* target = appModel->getTarget(targetIds[i]);
+            if(target->regions.size() > 0){
+                targetsWithRegions.add(target);
+            }
+        }
+
+        bool exportsAllTargets = targetsWithRegions.size() > 1 and AlertWindow::showOkCancelBox(AlertWindow::QuestionIcon, "Export Regions", String(targetsWithRegions.size()) + " targets have regions, export the regions of all of them? Each target's files are named after it.", "All Targets", "This Target");
+
+        if(exportsAllTargets){
+            FileChooser directoryChooser ("Saving regions of " + String(targetsWithRegions.size()) + " targets into...");
+            if(directoryChooser.browseForDirectory()){
+                BatchExportPlan* plan = new BatchExportPlan();
+                for(int i=0; i<targetsWithRegions.size(); i++){
+                    plan->addFileToDirectory(targetsWithRegions[i]->file->getFile(), targetsWithRegions[i]->regions, directoryChooser.getResult(), exportParams->formatExtension);
+                }
+                analysisController->saveBatchToAudioFiles(plan, exportParams);
+            }
         }
         else{
-            prompt += " as multiple files...";
+            String prompt = "Saving " + String(appModel->getTargetRegions()->size()) + " regions";
+            if(exportParams->asOneFile){
+                prompt += " as one file...";
+            }
+            else{
+                prompt += " as multiple files...";
+            }
+
+            FileChooser myChooser (prompt);
+            if (myChooser.browseForFileToSave(true))
+            {
+                File destinationFile = myChooser.getResult();
+                analysisController->saveRegionsToAudioFile(appModel->getTargetRegions(), appModel->getSegaudioFile(appModel->getActiveTargetId()), destinationFile, exportParams);
+            }
         }
-
-        FileChooser myChooser (prompt);
-        if (myChooser.browseForFileToSave(true))
-        {
-            File destinationFile = myChooser.getResult();
-            analysisController->saveRegionsToAudioFile(appModel->getTargetRegions(), appModel->getSegaudioFile("1"), destinationFile, exportParams->asOneFile);
+    }
+    else if(message == "exportStarted"){
+        exportProgressBar->setTextToDisplay(analysisController->getExportQueue()->getStatus());
+        exportProgressBar->setVisible(true);
+        exportCancelButton->setButtonText("Cancel");
+        exportCancelButton->setVisible(true);
+    }
+    else if(message == "regionsExported" or message == "exportCancelled"){
+        if(analysisController->getExportQueue()->getNumExports() == 0){ // the next one sends "exportStarted" otherwise
+            exportProgressBar->setTextToDisplay(ExportQueue::getSummaryText(analysisController->getExportQueue()->getLastSummary()));
+            exportCancelButton->setButtonText("Close");
         }
     }
     else if(message == "exportCsv"){
 
         String prompt = "Saving " + String(appModel->getTargetRegions()->size()) + " regions";
 
-        FileChooser myChooser (prompt);
+        FileChooser myChooser (prompt, File::nonexistent, "*.csv;*.jsonl;*.bin");
         if (myChooser.browseForFileToSave(true))
         {
             File destinationFile = myChooser.getResult();
-            destinationFile = destinationFile.withFileExtension(".csv");
+            RegionBoundaryWriter::Format format = RegionBoundaryWriter::getFormatForFile(destinationFile);
+            destinationFile = destinationFile.withFileExtension(RegionBoundaryWriter::getFileExtension(format));
 
-            analysisController->saveRegionsToTxtFile(appModel->getTargetRegions(), appModel->getSegaudioFile("1"), destinationFile);
+            analysisController->saveRegionsToTxtFile(appModel->getTargetRegions(), appModel->getSegaudioFile(appModel->getActiveTargetId()), destinationFile);
         }
     }
 
@@ -219,15 +343,29 @@ void MainComponent::actionListenerCallback(const juce::String &message){
 
 }
 
+void MainComponent::buttonClicked(Button* buttonThatWasClicked){
+
+    if(buttonThatWasClicked == exportCancelButton){
+        if(analysisController->getExportQueue()->getNumExports() > 0){
+            analysisController->getExportQueue()->cancelCurrentExport(); // the report shows what was written
+        }
+        else{
+            exportProgressBar->setVisible(false);
+            exportCancelButton->setVisible(false);
+        }
+    }
+}
+
 void MainComponent::newRegionsUpdate(){
-    analysisController->getClusterRegions(controlPanelComponent->getClusterParams(), appModel->getDistanceArray(), appModel->getMaxDistance(), appModel->getTargetRegions());
+    analysisController->getClusterRegions(controlPanelComponent->getClusterParams(), appModel->getDistanceArray(), appModel->getMaxDistance(), appModel->getTargetRegions(), appModel->getSegaudioFile(appModel->getActiveTargetId()), appModel->getDistanceStatistics());
+    targetFileComponent->updateRegions();
     targetFileComponent->repaint();
     controlPanelComponent->newRegionsUpdate(appModel->getTargetRegions());
 }
 
 bool MainComponent::isReadyToCompare(){
     if(isRefFileLoaded and isTargetFileLoaded and isRegionSelected){
-        return true;
+        return appModel->areFilesLoaded();
     }
     return false;
 }
@@ -239,6 +377,32 @@ bool MainComponent::isReadyForExport() {
     return false;
 }
 
+void MainComponent::showActiveTarget(){
+    targetFileComponent->showFile(appModel->getSegaudioFile(appModel->getActiveTargetId()));
+    targetFileComponent->setRegions(appModel->getTargetRegions());
+    targetFileComponent->setTuningParameters(controlPanelComponent->getClusterParams(), appModel->getDistanceArray(), appModel->getMaxDistance());
+    targetFileComponent->updateRegions();
+    targetFileComponent->repaint();
+    controlPanelComponent->newRegionsUpdate(appModel->getTargetRegions());
+}
+
+bool MainComponent::calculateNextTarget(){
+
+    if(pendingTargetIds.isEmpty()){
+        return false;
+    }
+
+    calculatingTargetId = pendingTargetIds[0];
+    pendingTargetIds.remove(0);
+    TargetAnalysis* target = appModel->getTarget(calculatingTargetId);
+
+    // regions only show up while analysing for the target that's shown
+    analysisController->setOnlineSegmentation(calculatingTargetId == appModel->getActiveTargetId() ? controlPanelComponent->getClusterParams() : nullptr);
+
+    analysisController->calculateDistances(&target->distanceArray, &target->maxDistance, appModel->getSegaudioFile("0"), target->file, appModel->getReferenceRegions(), controlPanelComponent->getSignalFeaturesToUse(appModel->getSignalFeaturesToUse()));
+    return true;
+}
+
 //[/MiscUserCode]
 
 
@@ -252,7 +416,7 @@ bool MainComponent::isReadyForExport() {
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="MainComponent" componentName=""
-                 parentClasses="public Component, public ActionListener" constructorParams="AudioAnalysisController &amp;analysisController"
+                 parentClasses="public Component, public ActionListener, public ButtonListener" constructorParams="AudioAnalysisController &amp;analysisController"
                  variableInitialisers="analysisController(&amp;analysisController)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
                  fixedSize="0" initialWidth="1000" initialHeight="600">
@@ -40,7 +40,8 @@
                                                                     //[/Comments]
 */
 class MainComponent  : public Component,
-                       public ActionListener
+                       public ActionListener,
+                       public ButtonListener
 {
 public:
     //==============================================================================
@@ -51,6 +52,12 @@ public:
     //[UserMethods]     -- You can add your own custom methods in this section.
     virtual void actionListenerCallback(const String &message);
 
+    /*! cancels the running export, or hides the export report once all are done
+        @param Button* buttonThatWasClicked
+        @return void
+    */
+    void buttonClicked(Button* buttonThatWasClicked);
+
     /*! perform some updates when there are new regions to show
         @return void
     */
@@ -63,6 +70,16 @@ public:
 
     bool isReadyForExport();
 
+    /*! points the target component at the active target in the model
+        @return void
+    */
+    void showActiveTarget();
+
+    /*! starts calculating the similarity for the next target waiting, one at a time on the analysis thread
+        @return bool: false if no targets are left
+    */
+    bool calculateNextTarget();
+
     //[/UserMethods]
 
     void paint (Graphics& g);
@@ -81,8 +98,14 @@ private:
     bool isTargetFileLoaded;
     bool isRegionSelected;
 
+    StringArray pendingTargetIds; // targets waiting for their similarity calculation
+    String calculatingTargetId; // target on the analysis thread
+
     TooltipWindow tooltipWindow;
 
+    ScopedPointer<ProgressBar> exportProgressBar; // shows the running export, then the summary of the last one
+    ScopedPointer<TextButton> exportCancelButton;
+
     //[/UserVariables]
 
     //==============================================================================
@@ -0,0 +1,121 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "OnlineRegionSegmenter.h"
+
+OnlineRegionSegmenter::OnlineRegionSegmenter(){
+    reset(ClusterParameters(), 0, 0);
+}
+
+OnlineRegionSegmenter::~OnlineRegionSegmenter(){
+}
+
+void OnlineRegionSegmenter::reset(ClusterParameters clusterParams, int totalNumBlocks, int lookAheadBlocks){
+
+    params = clusterParams;
+    connWidth = clusterParams.regionConnectionWidth*50.0f + 1; // same as getClusterRegions, up to 51 blocks
+    numBlocks = totalNumBlocks;
+    lookAhead = lookAheadBlocks;
+
+    pendingDistances.clearQuick();
+    nextBlockToDecide = 0;
+    maxDistanceSoFar = 0;
+
+    isInRegion = false;
+    regionStartBlock = 0;
+    lastAcceptedBlock = 0;
+
+    finishedRegions.clearQuick();
+}
+
+void OnlineRegionSegmenter::addDistance(float distance){
+
+    if(distance > maxDistanceSoFar){
+        maxDistanceSoFar = distance;
+    }
+
+    pendingDistances.add(distance);
+
+    while(pendingDistances.size() > lookAhead){
+        decideNextBlock();
+    }
+}
+
+void OnlineRegionSegmenter::finish(){
+
+    while(pendingDistances.size() > 0){
+        decideNextBlock();
+    }
+
+    if(isInRegion){
+        finishRegion();
+    }
+}
+
+int OnlineRegionSegmenter::takeFinishedRegions(Array<Range<int> >* regions){
+
+    int numFinished = finishedRegions.size();
+
+    regions->addArray(finishedRegions);
+    finishedRegions.clearQuick();
+
+    return numFinished;
+}
+
+void OnlineRegionSegmenter::decideNextBlock(){
+
+    int blockIdx = nextBlockToDecide;
+    float distance = pendingDistances.getFirst();
+
+    pendingDistances.remove(0);
+    nextBlockToDecide += 1;
+
+    bool isAccepted = distance < params.threshold * maxDistanceSoFar;
+
+    if(isAccepted){
+        if(isInRegion and blockIdx - lastAcceptedBlock <= connWidth){ // connects to current region
+            lastAcceptedBlock = blockIdx;
+        }
+        else{
+            if(isInRegion){
+                finishRegion();
+            }
+            isInRegion = true; // start next region
+            regionStartBlock = blockIdx;
+            lastAcceptedBlock = blockIdx;
+        }
+    }
+    else if(isInRegion and blockIdx - lastAcceptedBlock > connWidth){ // gap too wide, nothing can connect anymore
+        finishRegion();
+    }
+}
+
+void OnlineRegionSegmenter::finishRegion(){
+
+    isInRegion = false;
+
+    if(numBlocks <= 0){
+        return;
+    }
+
+    float regionFracWidth = (float(lastAcceptedBlock) - float(regionStartBlock)) / numBlocks;
+
+    // same width filter as AudioAnalysisController::isRegionWithinWidth
+    if(regionFracWidth > params.minRegionTimeWidth / 10 and regionFracWidth < params.maxRegionTimeWidth){
+        finishedRegions.add(Range<int>(regionStartBlock, lastAcceptedBlock));
+    }
+}
@@ -0,0 +1,94 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef ONLINEREGIONSEGMENTER_H_INCLUDED
+#define ONLINEREGIONSEGMENTER_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "SegaudioModel.h"
+
+/*! finds regions while distances are still being calculated, instead of after the whole similarity function
+
+    Uses the same threshold, connection width and width rules as AudioAnalysisController::getClusterRegions. The
+    threshold is relative to the max distance, which isn't known until the end, so each block is only decided once
+    lookAheadBlocks more distances came in, using the max seen so far. A region is finished as soon as the gap after
+    its last accepted block is wider than the connection width, so latency is bounded by look-ahead plus connection
+    width. Inverting regions needs the whole file and is left to the offline pass.
+*/
+class OnlineRegionSegmenter
+{
+
+public:
+    OnlineRegionSegmenter();
+    ~OnlineRegionSegmenter();
+
+    /*! starts a new pass
+        @param ClusterParameters clusterParams: threshold, connection width and width filter to use
+        @param int totalNumBlocks: expected number of distances, needed for the width filter
+        @param int lookAheadBlocks: number of distances to wait before deciding on a block
+        @return void
+    */
+    void reset(ClusterParameters clusterParams, int totalNumBlocks, int lookAheadBlocks);
+
+    /*! adds the next distance of the similarity function
+        @param float distance
+        @return void
+    */
+    void addDistance(float distance);
+
+    /*! decides the remaining blocks when there are no more distances
+        @return void
+    */
+    void finish();
+
+    /*! moves regions finished since the last call
+        @param Array<Range<int>>* finishedRegions: start and end block of each region, added to the end
+        @return int: number of regions added
+    */
+    int takeFinishedRegions(Array<Range<int> >* finishedRegions);
+
+private:
+
+    /*! decides if the oldest pending block is accepted and updates the current region
+        @return void
+    */
+    void decideNextBlock();
+
+    /*! applies the width filter and keeps the current region if it passes
+        @return void
+    */
+    void finishRegion();
+
+    ClusterParameters params;
+    float connWidth; // max gap in blocks between accepted blocks of one region
+    int numBlocks; // expected total blocks for width filter
+    int lookAhead;
+
+    Array<float> pendingDistances; // distances waiting for look-ahead, oldest first
+    int nextBlockToDecide; // block index of pendingDistances[0]
+    float maxDistanceSoFar;
+
+    bool isInRegion;
+    int regionStartBlock;
+    int lastAcceptedBlock;
+
+    Array<Range<int> > finishedRegions; // regions waiting to be taken
+};
+
+
+
+#endif  // ONLINEREGIONSEGMENTER_H_INCLUDED
@@ -79,7 +79,7 @@ void ReferenceContainer::resized()
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-void ReferenceContainer::setFile(juce::File &newFile){
+void ReferenceContainer::setFile(SegaudioFile* newFile){
     audioSelector->setFile(newFile);
 }
 
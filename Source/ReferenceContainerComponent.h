@@ -51,7 +51,7 @@ public:
     // NOTE: These are all passthrough functions
     // I know there's probably a better way, but didn't have the time...
 
-    void setFile(File &newFile);
+    void setFile(SegaudioFile* newFile);
 
     void setCandidateRegions(Array<AudioRegion> newCandidateRegions);
 
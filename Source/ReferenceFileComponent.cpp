@@ -82,6 +82,9 @@ ReferenceFileComponent::ReferenceFileComponent (AudioDeviceManager& deviceManage
     container->addActionListener(this);
 
     currentFile = new SegaudioFile();
+    currentFile->addActionListener(this); // "fileLoaded" when decoding finishes
+
+    addChildComponent(loadProgressBar = new ProgressBar(currentFile->getLoadProgress()));
 
     //[/Constructor]
 }
@@ -128,6 +131,7 @@ void ReferenceFileComponent::resized()
     //[UserResized] Add your own custom resize handling here..
 
     container->setSize(getWidth(), getHeight());
+    loadProgressBar->setBounds(320, 8, 150, 24);
     //[/UserResized]
 }
 
@@ -158,11 +162,13 @@ void ReferenceFileComponent::buttonClicked (Button* buttonThatWasClicked)
             // expl: transport tries to release resources, but still points to currentFile->getSource()
 
             File selectedFile = myChooser.getResult();
-            currentFile->setFile(selectedFile);
+            currentFile->setFile(selectedFile); // cancels a file still loading
+            loadProgressBar->setVisible(not currentFile->isFullyLoaded());
 
-            container->setFile(selectedFile);
+            container->setFile(currentFile); // listens for the blocks before loading starts
+            currentFile->startLoading();
 
-            audioTransport.setSource(currentFile->getSource());
+            audioTransport.setSource(currentFile->getSource(), SegaudioFile::readAheadSamples, &SegaudioFile::getReadAheadThread()); // buffered, reads off the audio callback
 
             isPlayable = true;
             setPlayable(true);
@@ -214,6 +220,11 @@ void ReferenceFileComponent::actionListenerCallback(const juce::String &message)
     if(message == "srcRegionSelected"){
         sendActionMessage(message);
     }
+
+    if(message == "fileLoaded" and currentFile->isFullyLoaded()){ // a late one from a file picked before isn't for this file
+        loadProgressBar->setVisible(false);
+        sendActionMessage("referenceFileLoaded");
+    }
 }
 
 void ReferenceFileComponent::playAudio(){
@@ -106,6 +106,7 @@ private:
     //[UserVariables]   -- You can add your own custom variables in this section.
     bool isPlayable;
     ScopedPointer<SegaudioFile> currentFile;     // loaded file, keeping this here bc load button is here
+    ScopedPointer<ProgressBar> loadProgressBar; // shown while currentFile is decoding, after currentFile so it's deleted first
 
     AudioTransportSource audioTransport; // handle audio transport
     AudioSourcePlayer audioSourcePlayer; // handle audio playback
@@ -0,0 +1,141 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "RegionBoundaryWriter.h"
+
+RegionBoundaryWriter::RegionBoundaryWriter(OutputStream* outputStream, Format format, int64 totalNumSamples, double sampleRate) : output(outputStream), format(format){
+    numSamples = totalNumSamples;
+    rate = sampleRate;
+    hasFailed = false;
+
+    if(format == binary){
+        bool isWritten = output->write("SGRB", 4);
+        isWritten = isWritten and output->writeInt(binaryVersion);
+        isWritten = isWritten and output->writeDouble(rate);
+        isWritten = isWritten and output->writeInt64(numSamples);
+        hasFailed = not isWritten;
+    }
+}
+
+RegionBoundaryWriter::~RegionBoundaryWriter(){
+    output->flush();
+}
+
+bool RegionBoundaryWriter::writeRegion(AudioRegion region){
+
+    if(hasFailed){
+        return false;
+    }
+
+    int64 startSample = region.getStartSample(numSamples);
+    int64 endSample = region.getEndSample(numSamples);
+    bool hasScore = region.hasScore();
+
+    bool isWritten = true;
+
+    if(format == binary){
+        isWritten = isWritten and output->writeInt64(startSample);
+        isWritten = isWritten and output->writeInt64(endSample);
+        isWritten = isWritten and output->writeFloat(hasScore ? region.getMeanDistance() : 0.0f);
+        isWritten = isWritten and output->writeFloat(hasScore ? region.getMinDistance() : 0.0f);
+        isWritten = isWritten and output->writeFloat(hasScore ? region.getAreaDistance() : 0.0f);
+        isWritten = isWritten and output->writeInt(hasScore ? 1 : 0);
+    }
+    else{
+        // seconds from exact samples, floats can't hold sample positions in long files
+        String startSeconds(startSample / rate, 6);
+        String endSeconds(endSample / rate, 6);
+
+        String line;
+        line.preallocateBytes(160);
+
+        if(format == jsonLines){
+            line << "{\"start\": " << startSeconds << ", \"end\": " << endSeconds
+                 << ", \"startSample\": " << startSample << ", \"endSample\": " << endSample;
+            if(hasScore){
+                line << ", \"meanDistance\": " << scoreToText(region.getMeanDistance(), "null") << ", \"minDistance\": " << scoreToText(region.getMinDistance(), "null")
+                     << ", \"areaDistance\": " << scoreToText(region.getAreaDistance(), "null") << "}\n";
+            }
+            else{
+                line << ", \"meanDistance\": null, \"minDistance\": null, \"areaDistance\": null}\n";
+            }
+        }
+        else{
+            line << startSeconds << ", " << endSeconds << ", " << startSample << ", " << endSample;
+            if(hasScore){
+                line << ", " << scoreToText(region.getMeanDistance(), String::empty) << ", " << scoreToText(region.getMinDistance(), String::empty)
+                     << ", " << scoreToText(region.getAreaDistance(), String::empty) << "\n";
+            }
+            else{
+                line << ", , , \n";
+            }
+        }
+
+        isWritten = output->write(line.toRawUTF8(), line.getNumBytesAsUTF8());
+    }
+
+    hasFailed = not isWritten;
+    return isWritten;
+}
+
+String RegionBoundaryWriter::scoreToText(float score, const String &missingValue){
+    if(not juce_isfinite(score)){
+        return missingValue;
+    }
+    return String(score);
+}
+
+RegionBoundaryWriter::Format RegionBoundaryWriter::getFormatForFile(const File &file){
+    if(file.hasFileExtension("jsonl")){
+        return jsonLines;
+    }
+    if(file.hasFileExtension("bin")){
+        return binary;
+    }
+    return csv;
+}
+
+String RegionBoundaryWriter::getFileExtension(Format format){
+    if(format == jsonLines){
+        return ".jsonl";
+    }
+    if(format == binary){
+        return ".bin";
+    }
+    return ".csv";
+}
+
+bool RegionBoundaryWriter::writeRegions(Array<AudioRegion>* regions, const File &destinationFile, Format format, int64 totalNumSamples, double sampleRate){
+
+    destinationFile.deleteFile(); // output streams append
+    FileOutputStream* destOutputStream = new FileOutputStream(destinationFile, 1 << 16);
+    if(destOutputStream->failedToOpen()){
+        delete destOutputStream;
+        return false;
+    }
+
+    RegionBoundaryWriter boundaryWriter(destOutputStream, format, totalNumSamples, sampleRate);
+
+    bool isWritten = true;
+    for(int i=0; i<regions->size() and isWritten; i++){
+        isWritten = boundaryWriter.writeRegion(regions->getReference(i));
+    }
+
+    // the last buffered block is written here, not when the writer deletes the stream, so a full disk is reported
+    destOutputStream->flush();
+    return isWritten and not destOutputStream->getStatus().failed();
+}
@@ -0,0 +1,102 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef REGIONBOUNDARYWRITER_H_INCLUDED
+#define REGIONBOUNDARYWRITER_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+
+/*! streams region boundaries and scores to a file one region at a time, so long lists never sit in one String
+
+    CSV and JSON Lines hold start and end in seconds and in samples, then mean, min and area distance. The binary
+    format starts with the magic "SGRB", a version int, the sample rate as a double and the file length in samples,
+    followed by 32 byte records: start and end sample as int64, the three distances as floats and a flags int that
+    is 1 for scored regions. Everything is little endian. Distances that aren't finite are written like missing
+    scores in the text formats, null in JSON Lines and empty in CSV, the binary format keeps the IEEE value.
+*/
+class RegionBoundaryWriter
+{
+
+public:
+    enum Format{
+        csv,
+        jsonLines,
+        binary
+    };
+
+    static const int binaryVersion = 1;
+    static const int binaryHeaderSize = 24;
+    static const int binaryRecordSize = 32;
+
+    /*! writes the header of the format, if it has one
+        @param OutputStream* outputStream: deleted by the writer
+        @param Format format
+        @param int64 totalNumSamples: length of the file the regions are from
+        @param double sampleRate: sample rate of the file the regions are from
+    */
+    RegionBoundaryWriter(OutputStream* outputStream, Format format, int64 totalNumSamples, double sampleRate);
+    ~RegionBoundaryWriter();
+
+    /*! appends one region
+        @param AudioRegion region
+        @return bool: false if the stream failed
+    */
+    bool writeRegion(AudioRegion region);
+
+    /*! picks the format from a file extension, ".jsonl" and ".bin" select those, anything else is CSV
+        @param const File &file
+        @return Format
+    */
+    static Format getFormatForFile(const File &file);
+
+    /*! gets the extension files of a format are saved with
+        @param Format format
+        @return String: with the dot
+    */
+    static String getFileExtension(Format format);
+
+    /*! writes all regions to a file through a buffered stream
+        @param Array<AudioRegion>* regions
+        @param const File &destinationFile: replaced if it exists
+        @param Format format
+        @param int64 totalNumSamples
+        @param double sampleRate
+        @return bool: false if the file couldn't be written
+    */
+    static bool writeRegions(Array<AudioRegion>* regions, const File &destinationFile, Format format, int64 totalNumSamples, double sampleRate);
+
+private:
+    ScopedPointer<OutputStream> output;
+    Format format;
+    int64 numSamples;
+    double rate;
+
+    bool hasFailed; // set on the first failed write, the rest are skipped
+
+    /*! formats one distance for the text formats
+        @param float score
+        @param const String &missingValue: written instead of nan and inf, which JSON has no numbers for
+        @return String
+    */
+    static String scoreToText(float score, const String &missingValue);
+
+    JUCE_DECLARE_NON_COPYABLE (RegionBoundaryWriter)
+};
+
+
+#endif  // REGIONBOUNDARYWRITER_H_INCLUDED
@@ -0,0 +1,336 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "RegionExporter.h"
+
+/*! the writer thread of single file exports, deleted with JUCE's other singletons so it stops while JUCE is still up
+*/
+class SharedWriterThread : public TimeSliceThread,
+                           public DeletedAtShutdown
+{
+public:
+    SharedWriterThread() : TimeSliceThread("Segaudio Export Writer"){}
+
+    ~SharedWriterThread(){
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (SharedWriterThread, false)
+};
+
+juce_ImplementSingleton (SharedWriterThread)
+
+RegionExporter::RegionExporter(SegaudioFile* sourceFile, const Array<AudioRegion> &regions, const File &destinationFile, String formatExtension) :
+    sourceFile(sourceFile),
+    regions(regions),
+    destinationFile(destinationFile),
+    formatExtension(formatExtension)
+{
+    formatManager.registerBasicFormats();
+    format = formatManager.findFormatForFileExtension(formatExtension);
+    if(format == nullptr){ // unknown extension
+        this->formatExtension = "wav";
+        format = formatManager.findFormatForFileExtension("wav");
+    }
+
+    if(sourceFile->isMemoryMapped() and this->formatExtension == "wav"){
+        copier = new WavRegionCopier(sourceFile->getFile());
+    }
+
+    progressStart = 0;
+    progressRange = 1;
+    copyProgress = nullptr;
+    writesOnCallingThread = false;
+
+    numSamplesToWrite = 0;
+    Array<Range<int64> > sampleRanges = getSampleRanges();
+    for(int i=0; i<sampleRanges.size(); i++){
+        numSamplesToWrite += sampleRanges.getReference(i).getLength();
+    }
+}
+
+RegionExporter::~RegionExporter(){
+}
+
+bool RegionExporter::exportToSingleFile(double gapSeconds, double crossfadeSeconds, double* progress){
+
+    numSamplesWritten = 0;
+    numBytesWritten = 0;
+    numWritten = 0;
+    numFailed = 0;
+
+    Array<Range<int64> > sampleRanges = getSampleRanges();
+    File regionsFile = destinationFile.withFileExtension(formatExtension);
+
+    int gapSamples = roundDoubleToInt(gapSeconds * sourceFile->getSampleRate());
+    int crossfadeSamples = roundDoubleToInt(crossfadeSeconds * sourceFile->getSampleRate());
+    bool isJoinedDirectly = (gapSamples <= 0 and crossfadeSamples <= 0);
+
+    bool isWritten = false;
+    bool isCopied = false;
+    if(isJoinedDirectly and copier != nullptr and copier->canCopy()){ // lossless and without decoding
+        copyProgress = progress;
+        isCopied = isWritten = copier->writeRanges(regionsFile, sampleRanges, this);
+        copyProgress = nullptr;
+    }
+    if(not isCopied and not isCancelled()){
+        numSamplesWritten = 0; // a copy that failed part way counted some
+        regionsFile.deleteFile(); // output streams append
+        FileOutputStream* destOutputStream = regionsFile.createOutputStream();
+        AudioFormatWriter* writer = nullptr;
+        if(destOutputStream != nullptr){
+            writer = createWriter(format, destOutputStream, sourceFile); // keeps the bit depth
+        }
+
+        // reading the next chunk while the last one is encoded and written
+        TimeSliceThread* writerThread = writesOnCallingThread ? nullptr : &getWriterThread();
+        isWritten = (writer != nullptr and writeRanges(writer, sampleRanges, gapSamples, crossfadeSamples, writerThread, progress));
+    }
+
+    numBytesWritten = regionsFile.getSize();
+    if(not isWritten){
+        numFailed = regions.size();
+        return false;
+    }
+
+    numWritten = regions.size();
+    if(progress != nullptr){
+        *progress = progressStart + progressRange;
+    }
+    return true;
+}
+
+bool RegionExporter::exportToSeparateFiles(double* progress){
+
+    numSamplesWritten = 0;
+    numBytesWritten = 0;
+    numFinished = 0;
+    numWritten = 0;
+    numFailed = 0;
+    int numRegions = regions.size();
+
+    if(writesOnCallingThread){
+        for(int i=0; i<numRegions and not isCancelled(); i++){
+            ExportJob(*this, i).runJob();
+            if(progress != nullptr){
+                *progress = progressStart + progressRange * double(numSamplesWritten.get()) / jmax<int64>(1, numSamplesToWrite);
+            }
+        }
+        return not isCancelled();
+    }
+
+    // writing is mostly waiting for the disk, the pool only bounds how many files are open at once
+    ThreadPool exportPool(jmax(1, jmin(SystemStats::getNumCpus() - 1, numRegions)));
+    for(int i=0; i<numRegions; i++){
+        exportPool.addJob(new ExportJob(*this, i), true);
+    }
+
+    while(numFinished.get() < numRegions){
+        if(isCancelled()){ // files already written stay
+            exportPool.removeAllJobs(true, 10000);
+            return false;
+        }
+        if(progress != nullptr){
+            *progress = progressStart + progressRange * double(numSamplesWritten.get()) / jmax<int64>(1, numSamplesToWrite);
+        }
+        Thread::sleep(100);
+    }
+
+    if(progress != nullptr){
+        *progress = progressStart + progressRange;
+    }
+    return true;
+}
+
+void RegionExporter::setWritesOnCallingThread(bool shouldWriteOnCallingThread){
+    writesOnCallingThread = shouldWriteOnCallingThread;
+}
+
+void RegionExporter::setProgressRange(double start, double range){
+    progressStart = start;
+    progressRange = range;
+}
+
+void RegionExporter::cancel(){
+    shouldCancel = 1;
+}
+
+bool RegionExporter::isCancelled(){
+    return shouldCancel.get() != 0;
+}
+
+int RegionExporter::getNumWritten(){
+    return numWritten.get();
+}
+
+int RegionExporter::getNumFailed(){
+    return numFailed.get();
+}
+
+int64 RegionExporter::getNumBytesWritten(){
+    return numBytesWritten.get();
+}
+
+Array<Range<int64> > RegionExporter::getSampleRanges(){
+
+    int64 totalNumSamples = sourceFile->getNumSamples();
+
+    Array<Range<int64> > sampleRanges;
+    for(int i=0; i<regions.size(); i++){
+        sampleRanges.add(Range<int64>(regions.getReference(i).getStartSample(totalNumSamples), regions.getReference(i).getEndSample(totalNumSamples)));
+    }
+    return sampleRanges;
+}
+
+bool RegionExporter::exportRegion(int regionIdx){
+
+    if(isCancelled()){
+        return false;
+    }
+
+    int64 totalNumSamples = sourceFile->getNumSamples();
+    int64 regionStartSample = regions.getReference(regionIdx).getStartSample(totalNumSamples);
+    int64 regionEndSample = regions.getReference(regionIdx).getEndSample(totalNumSamples);
+
+    File regionFile = getRegionFile(destinationFile, regionIdx, regions.size(), regionStartSample, regionEndSample, sourceFile->getSampleRate(), formatExtension);
+
+    Array<Range<int64> > regionRange;
+    regionRange.add(Range<int64>(regionStartSample, regionEndSample));
+
+    if(copier != nullptr and copier->canCopy()){ // lossless and without decoding, samples are counted per chunk
+        if(copier->writeRanges(regionFile, regionRange, this)){
+            numBytesWritten += regionFile.getSize();
+            return true;
+        }
+        if(isCancelled()){
+            numBytesWritten += regionFile.getSize();
+            return false;
+        }
+    }
+
+    regionFile.deleteFile(); // output streams append
+    FileOutputStream* destOutputStream = regionFile.createOutputStream();
+    if(destOutputStream == nullptr){
+        return false;
+    }
+
+    AudioFormatWriter* writer = createWriter(format, destOutputStream, sourceFile);
+    if(writer == nullptr){
+        return false;
+    }
+
+    // the other jobs keep the disk busy while this one reads, so no writer thread
+    bool isWritten = writeRanges(writer, regionRange, 0, 0, nullptr, nullptr);
+    numBytesWritten += regionFile.getSize();
+    return isWritten;
+}
+
+AudioFormatWriter* RegionExporter::createWriter(AudioFormat* format, OutputStream* stream, SegaudioFile* sourceFile){
+
+    Array<int> bitDepths = format->getPossibleBitDepths(); // ascending
+    int bitsPerSample = bitDepths.getLast();
+    for(int i=0; i<bitDepths.size(); i++){
+        if(bitDepths[i] >= sourceFile->getBitsPerSample()){
+            bitsPerSample = bitDepths[i];
+            break;
+        }
+    }
+
+    // the middle option, a fair bit rate for Ogg and the usual compression level for FLAC, ignored by WAV
+    int qualityOptionIndex = format->getQualityOptions().size() / 2;
+
+    AudioFormatWriter* writer = format->createWriterFor(stream, sourceFile->getSampleRate(), sourceFile->getNumChannels(), bitsPerSample, StringPairArray(), qualityOptionIndex);
+    if(writer == nullptr){
+        delete stream;
+    }
+    return writer;
+}
+
+File RegionExporter::getRegionFile(const File &destinationFile, int regionIdx, int numRegions, int64 startSample, int64 endSample, double sampleRate, String formatExtension){
+
+    int64 wholeSampleRate = jmax<int64>(1, int64(sampleRate)); // whole seconds in file names
+    int numDigits = String(jmax(1, numRegions - 1)).length();
+
+    // the destination's extension is dropped here, withFileExtension would cut the name at a dot in the suffix
+    String regionName = destinationFile.getFileNameWithoutExtension() + "_" + String(regionIdx).paddedLeft('0', numDigits) + "_" + String(startSample / wholeSampleRate) + "-" + String(endSample / wholeSampleRate);
+    return destinationFile.getParentDirectory().getChildFile(regionName + "." + formatExtension);
+}
+
+bool RegionExporter::writeRanges(AudioFormatWriter* writer, const Array<Range<int64> > &sampleRanges, int gapSamples, int crossfadeSamples, TimeSliceThread* writerThread, double* progress){
+
+    const int chunkSize = 65536; // samples per read, the renderer writes whole blocks of them
+
+    ScopedPointer<AudioFormatReader> reader; // memory mapped files read from the map, paged by the OS
+    if(not sourceFile->isMemoryMapped()){
+        reader = sourceFile->createReader();
+        if(reader == nullptr){
+            delete writer;
+            return false;
+        }
+    }
+
+    RegionRenderer renderer(writer, sourceFile->getNumChannels(), writerThread); // writes what's left when it goes out of scope
+    renderer.setJoin(gapSamples, crossfadeSamples);
+
+    for(int i=0; i<sampleRanges.size(); i++){
+        int64 startSample = sampleRanges.getReference(i).getStart();
+        int64 endSample = jmin(sampleRanges.getReference(i).getEnd(), sourceFile->getNumSamples());
+
+        renderer.startRegion(endSample - startSample);
+
+        while(startSample < endSample){
+            if(isCancelled()){ // the writer still finishes the file with what's written
+                return false;
+            }
+
+            // read straight into the block, no copy before writing
+            int numSamplesInChunk = renderer.prepareSpace(int(jmin<int64>(chunkSize, endSample - startSample)));
+            if(reader != nullptr){
+                reader->read(renderer.getBlock(), renderer.getWritePosition(), numSamplesInChunk, startSample, true, true);
+            }
+            else{
+                sourceFile->readSamples(renderer.getBlock(), renderer.getWritePosition(), startSample, numSamplesInChunk);
+            }
+            renderer.commit(numSamplesInChunk);
+            startSample += numSamplesInChunk;
+
+            numSamplesWritten += numSamplesInChunk;
+            if(progress != nullptr){
+                *progress = progressStart + progressRange * double(numSamplesWritten.get()) / jmax<int64>(1, numSamplesToWrite);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool RegionExporter::framesCopied(int64 numFrames){
+
+    numSamplesWritten += numFrames;
+    if(copyProgress != nullptr){
+        *copyProgress = progressStart + progressRange * double(numSamplesWritten.get()) / jmax<int64>(1, numSamplesToWrite);
+    }
+    return not isCancelled();
+}
+
+TimeSliceThread& RegionExporter::getWriterThread(){
+    TimeSliceThread* writerThread = SharedWriterThread::getInstance();
+    if(not writerThread->isThreadRunning()){
+        writerThread->startThread();
+    }
+    return *writerThread;
+}
@@ -0,0 +1,214 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef REGIONEXPORTER_H_INCLUDED
+#define REGIONEXPORTER_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "AudioRegion.h"
+#include "SegaudioFile.h"
+#include "WavRegionCopier.h"
+#include "RegionRenderer.h"
+
+/*! writes regions to WAV, FLAC or Ogg, one after another into one file or every region to its own file on a pool
+    of export threads. Exports block the calling thread, an ExportQueue runs them off the message thread
+
+    Only reads from the source file, and each job has its own writer. File names only depend on the destination,
+    the region's position in the list and its times, so exporting the same regions always gives the same files.
+    Progress, cancelling and the byte count can be used from any thread while an export runs.
+*/
+class RegionExporter : public WavRegionCopier::Listener
+{
+
+public:
+    /*! sets up the export
+        @param SegaudioFile* sourceFile: has to stay set until the export is done
+        @param const Array<AudioRegion> &regions: copied, so editing regions meanwhile doesn't matter
+        @param const File &destinationFile: regions are saved next to it, named after it
+        @param String formatExtension: "wav", "flac" or "ogg"
+    */
+    RegionExporter(SegaudioFile* sourceFile, const Array<AudioRegion> &regions, const File &destinationFile, String formatExtension);
+    ~RegionExporter();
+
+    /*! writes all regions one after another into the destination file, with the format's extension. PCM WAV sources
+        exported to WAV without gaps or crossfades are copied byte for byte, anything else is read while the last
+        block is written
+        @param double gapSeconds: silence between regions, 0 for none
+        @param double crossfadeSeconds: overlap between regions if there's no gap, 0 for none
+        @param double* progress: set from 0 to 1 while writing, nullptr if not needed
+        @return bool: false if the file couldn't be written or the export was cancelled
+    */
+    bool exportToSingleFile(double gapSeconds, double crossfadeSeconds, double* progress);
+
+    /*! writes every region to its own file in parallel, returns when all are written or the export is cancelled
+        @param double* progress: set from 0 to 1 while writing, nullptr if not needed
+        @return bool: false if cancelled, files already written stay
+    */
+    bool exportToSeparateFiles(double* progress);
+
+    /*! writes everything on the thread calling the export, for callers that already run one export per core. Separate
+        files are then written one after another instead of on a pool, and a single file is encoded without the
+        shared writer thread
+        @param bool shouldWriteOnCallingThread
+        @return void
+    */
+    void setWritesOnCallingThread(bool shouldWriteOnCallingThread);
+
+    /*! sets the part of the progress this export covers, when it's one of several
+        @param double start
+        @param double range
+        @return void
+    */
+    void setProgressRange(double start, double range);
+
+    /*! stops a running export from any thread, the export call returns soon after
+        @return void
+    */
+    void cancel();
+
+    /*! check if cancel was called
+        @return bool
+    */
+    bool isCancelled();
+
+    /*! gets how many regions were written so far
+        @return int
+    */
+    int getNumWritten();
+
+    /*! gets how many regions couldn't be written, after the export is done
+        @return int
+    */
+    int getNumFailed();
+
+    /*! gets the size of all files written so far
+        @return int64: bytes
+    */
+    int64 getNumBytesWritten();
+
+    /*! gets the file for one region, destination_<index>_<start>-<end>.<extension> with the index zero padded and the
+        times in whole seconds, the index keeps regions within the same seconds apart
+        @param const File &destinationFile: its extension, if any, is left out of the name
+        @param int regionIdx
+        @param int numRegions: for the padding
+        @param int64 startSample
+        @param int64 endSample
+        @param double sampleRate
+        @param String formatExtension
+        @return File
+    */
+    static File getRegionFile(const File &destinationFile, int regionIdx, int numRegions, int64 startSample, int64 endSample, double sampleRate, String formatExtension);
+
+    /*! creates a writer keeping the source's bit depth, or the closest one above it the format can write
+        @param AudioFormat* format
+        @param OutputStream* stream: deleted by the writer, or here if the writer can't be created
+        @param SegaudioFile* sourceFile: for the sample rate, channels and bit depth
+        @return AudioFormatWriter*: caller owns it, nullptr if the format can't write the source's layout
+    */
+    static AudioFormatWriter* createWriter(AudioFormat* format, OutputStream* stream, SegaudioFile* sourceFile);
+
+    /*! gets the thread that writes the single export file while the next chunk is read
+        @return TimeSliceThread&
+    */
+    static TimeSliceThread& getWriterThread();
+
+    /*! counts copied samples for the progress and stops the copy when cancelled, called by the copier
+        @param int64 numFrames
+        @return bool: false if cancelled
+    */
+    bool framesCopied(int64 numFrames);
+
+private:
+    SegaudioFile* sourceFile;
+    Array<AudioRegion> regions;
+    File destinationFile;
+
+    String formatExtension;
+    AudioFormatManager formatManager;
+    AudioFormat* format; // creating writers doesn't change it, shared by the jobs
+    ScopedPointer<WavRegionCopier> copier; // nullptr unless the source is a PCM WAV file exported to WAV, only reads
+
+    int64 numSamplesToWrite; // all regions, for the progress
+    double progressStart;
+    double progressRange;
+    Atomic<int64> numSamplesWritten;
+    Atomic<int64> numBytesWritten;
+    Atomic<int> numFinished;
+    Atomic<int> numWritten;
+    Atomic<int> numFailed;
+    Atomic<int> shouldCancel;
+    double* copyProgress; // progress of a single file export while the copier runs, nullptr otherwise
+    bool writesOnCallingThread; // no export pool and no writer thread
+
+    /*! gets the start and end sample of each region
+        @return Array<Range<int64> >
+    */
+    Array<Range<int64> > getSampleRanges();
+
+    /*! writes one region, called from the export threads
+        @param int regionIdx
+        @return bool: false if the file couldn't be written
+    */
+    bool exportRegion(int regionIdx);
+
+    /*! streams sample ranges to a writer through a RegionRenderer, one after another, so memory stays at a few MB
+        whatever the length of the source and writes are whole blocks however short the regions. Compressed sources
+        are read with a reader of their own instead of through the block cache, so exporting doesn't fill it. With a
+        writer thread, reading the next block and writing the last one overlap
+        @param AudioFormatWriter* writer: deleted when done, with its stream
+        @param const Array<Range<int64> > &sampleRanges: start and end sample of each region
+        @param int gapSamples: silence between regions
+        @param int crossfadeSamples: overlap between regions if there's no gap
+        @param TimeSliceThread* writerThread: writes in the background if not nullptr
+        @param double* progress: updated after every chunk if not nullptr
+        @return bool: false if the source couldn't be read or the export was cancelled
+    */
+    bool writeRanges(AudioFormatWriter* writer, const Array<Range<int64> > &sampleRanges, int gapSamples, int crossfadeSamples, TimeSliceThread* writerThread, double* progress);
+
+    /*! exports one region
+    */
+    class ExportJob : public ThreadPoolJob
+    {
+    public:
+
+        ExportJob(RegionExporter &owner, int regionToExport) : ThreadPoolJob("Segaudio Region Export"){
+            exporter = &owner;
+            regionIdx = regionToExport;
+        };
+
+        JobStatus runJob(){
+            if(exporter->exportRegion(regionIdx)){
+                ++exporter->numWritten;
+            }
+            else{
+                ++exporter->numFailed;
+            }
+            ++exporter->numFinished;
+            return jobHasFinished;
+        }
+
+    private:
+        RegionExporter* exporter;
+        int regionIdx;
+
+    };
+
+    JUCE_DECLARE_NON_COPYABLE (RegionExporter)
+};
+
+
+#endif  // REGIONEXPORTER_H_INCLUDED
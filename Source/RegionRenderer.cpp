@@ -0,0 +1,136 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "RegionRenderer.h"
+
+RegionRenderer::RegionRenderer(AudioFormatWriter* writer, int numChannels, TimeSliceThread* writerThread) : block(numChannels, blockSize){
+    writePosition = 0;
+    gapSamples = 0;
+    crossfadeSamples = 0;
+    isFirstRegion = true;
+    lastRegionSamples = 0;
+    fadePosition = 0;
+    fadeLength = 0;
+    fadeDone = 0;
+
+    if(writerThread != nullptr){
+        threadedWriter = new AudioFormatWriter::ThreadedWriter(writer, *writerThread, 2 * blockSize); // a whole block always fits
+    }
+    else{
+        directWriter = writer;
+    }
+}
+
+RegionRenderer::~RegionRenderer(){
+    flush();
+}
+
+void RegionRenderer::setJoin(int gapSamples, int crossfadeSamples){
+    this->gapSamples = jmax(0, gapSamples);
+    this->crossfadeSamples = (this->gapSamples > 0) ? 0 : jlimit(0, blockSize / 4, crossfadeSamples);
+}
+
+void RegionRenderer::startRegion(int64 numRegionSamples){
+
+    fadeLength = 0;
+    fadeDone = 0;
+
+    int64 previousRegionSamples = lastRegionSamples;
+    lastRegionSamples = numRegionSamples;
+
+    if(isFirstRegion){
+        isFirstRegion = false;
+        return;
+    }
+
+    for(int numSilent=0; numSilent<gapSamples; ){
+        int numSamples = prepareSpace(gapSamples - numSilent);
+        block.clear(writePosition, numSamples);
+        writePosition += numSamples;
+        numSilent += numSamples;
+    }
+
+    // the held back end of the block is the end of the last region, and of the ones before it if that was short
+    fadeLength = int(jmin<int64>(jmin<int64>(crossfadeSamples, writePosition), jmin(numRegionSamples, previousRegionSamples)));
+    fadePosition = writePosition - fadeLength;
+}
+
+int RegionRenderer::prepareSpace(int numSamplesWanted){
+
+    if(fadeDone < fadeLength){ // fade samples are mixed in place, so they are read in one fade at a time
+        numSamplesWanted = jmin(numSamplesWanted, fadeLength - fadeDone);
+    }
+
+    if(writePosition + numSamplesWanted > blockSize){
+        writeBlock(jmin(writePosition, crossfadeSamples));
+    }
+    return jmin(numSamplesWanted, blockSize - writePosition);
+}
+
+AudioSampleBuffer* RegionRenderer::getBlock(){
+    return &block;
+}
+
+int RegionRenderer::getWritePosition(){
+    return writePosition;
+}
+
+void RegionRenderer::commit(int numSamples){
+
+    if(fadeDone >= fadeLength){
+        writePosition += numSamples;
+        return;
+    }
+
+    // new samples fade in over the end of the last region, which fades out, and aren't kept where they were read
+    float startGain = float(fadeDone) / fadeLength;
+    float endGain = float(fadeDone + numSamples) / fadeLength;
+    for(int channel=0; channel<block.getNumChannels(); channel++){
+        block.applyGainRamp(channel, fadePosition + fadeDone, numSamples, 1.0f - startGain, 1.0f - endGain);
+        block.addFromWithRamp(channel, fadePosition + fadeDone, block.getSampleData(channel, writePosition), numSamples, startGain, endGain);
+    }
+    fadeDone += numSamples;
+}
+
+void RegionRenderer::flush(){
+    writeBlock(0);
+}
+
+void RegionRenderer::writeBlock(int numSamplesToKeep){
+
+    int numSamplesToWrite = writePosition - numSamplesToKeep;
+    if(numSamplesToWrite > 0){
+        if(threadedWriter != nullptr){
+            HeapBlock<const float*> channels(block.getNumChannels());
+            for(int channel=0; channel<block.getNumChannels(); channel++){
+                channels[channel] = block.getSampleData(channel);
+            }
+            while(not threadedWriter->write(channels, numSamplesToWrite)){
+                Thread::sleep(1); // fifo full, the writer thread catches up
+            }
+        }
+        else{
+            directWriter->writeFromAudioSampleBuffer(block, 0, numSamplesToWrite);
+        }
+    }
+
+    for(int channel=0; channel<block.getNumChannels() and numSamplesToKeep > 0; channel++){
+        memmove(block.getSampleData(channel), block.getSampleData(channel, numSamplesToWrite), numSamplesToKeep * sizeof(float));
+    }
+    fadePosition -= numSamplesToWrite;
+    writePosition = numSamplesToKeep;
+}
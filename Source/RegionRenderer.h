@@ -0,0 +1,112 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef REGIONRENDERER_H_INCLUDED
+#define REGIONRENDERER_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*! assembles regions one after another into large blocks before they go to a writer, with silence or a crossfade
+    between them, so many short regions still end up as a few big sequential writes
+
+    Samples are read straight into the block: prepareSpace says how many fit at getWritePosition, commit adds them.
+    With a crossfade the end of the block is held back until the next region has faded in over it. The fade is
+    linear and never longer than either region.
+*/
+class RegionRenderer
+{
+
+public:
+    static const int blockSize = 1 << 18; // samples per write
+
+    /*! @param AudioFormatWriter* writer: deleted by the renderer when it's done, with its stream
+        @param int numChannels: of the samples committed
+        @param TimeSliceThread* writerThread: writes in the background if not nullptr
+    */
+    RegionRenderer(AudioFormatWriter* writer, int numChannels, TimeSliceThread* writerThread);
+
+    /*! writes what's left in the block
+    */
+    ~RegionRenderer();
+
+    /*! sets what goes between regions, only one of them is used, the gap if both are set
+        @param int gapSamples: silence between regions
+        @param int crossfadeSamples: overlap between regions, at most a quarter block
+        @return void
+    */
+    void setJoin(int gapSamples, int crossfadeSamples);
+
+    /*! starts the next region, adding the gap or setting up the fade in
+        @param int64 numRegionSamples: length of the region
+        @return void
+    */
+    void startRegion(int64 numRegionSamples);
+
+    /*! makes room at the write position, writing out the block first if it's full
+        @param int numSamplesWanted
+        @return int: how many samples can be read in now, never more than numSamplesWanted
+    */
+    int prepareSpace(int numSamplesWanted);
+
+    /*! gets the block to read samples into, at getWritePosition
+        @return AudioSampleBuffer*
+    */
+    AudioSampleBuffer* getBlock();
+
+    /*! gets where the next samples go in the block
+        @return int
+    */
+    int getWritePosition();
+
+    /*! adds samples read in at the write position, fading them in over the end of the last region if needed
+        @param int numSamples: at most what prepareSpace returned
+        @return void
+    */
+    void commit(int numSamples);
+
+    /*! writes everything in the block, the end held back for a crossfade included
+        @return void
+    */
+    void flush();
+
+private:
+    AudioSampleBuffer block;
+    int writePosition; // samples in the block not written yet
+
+    ScopedPointer<AudioFormatWriter> directWriter;
+    ScopedPointer<AudioFormatWriter::ThreadedWriter> threadedWriter; // owns the writer, writes what's left when deleted
+
+    int gapSamples;
+    int crossfadeSamples;
+    bool isFirstRegion;
+
+    int64 lastRegionSamples; // a fade can't reach back past the start of the last region
+    int fadePosition; // where the new region is mixed into the last one
+    int fadeLength;
+    int fadeDone;
+
+    /*! writes the start of the block and moves the rest to the front
+        @param int numSamplesToKeep: at the end of the block, for a crossfade
+        @return void
+    */
+    void writeBlock(int numSamplesToKeep);
+
+    JUCE_DECLARE_NON_COPYABLE (RegionRenderer)
+};
+
+
+#endif  // REGIONRENDERER_H_INCLUDED
@@ -0,0 +1,144 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "SampleBlockCache.h"
+
+SampleBlockCache::SampleBlockCache(){
+    maxBytes = size_t(1024) * 1024 * 1024; // 1GB, about 3 hours of 16 bit stereo at 44.1kHz
+    currentBytes = 0;
+    tick = 0;
+    nextFileId = 1;
+}
+
+SampleBlockCache::~SampleBlockCache(){
+}
+
+/*! the cache of all files, freed with JUCE's other singletons after the files are gone instead of in static
+    destruction
+*/
+class SharedSampleBlockCache : public SampleBlockCache,
+                               public DeletedAtShutdown
+{
+public:
+    ~SharedSampleBlockCache(){
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (SharedSampleBlockCache, false)
+};
+
+juce_ImplementSingleton (SharedSampleBlockCache)
+
+SampleBlockCache& SampleBlockCache::getSharedCache(){
+    return *SharedSampleBlockCache::getInstance();
+}
+
+int SampleBlockCache::createFileId(){
+    const ScopedLock sl(lock);
+    return nextFileId++;
+}
+
+void SampleBlockCache::setMaxBytes(size_t newMaxBytes){
+    const ScopedLock sl(lock);
+    maxBytes = newMaxBytes;
+    evictToFit(0);
+}
+
+size_t SampleBlockCache::getMaxBytes(){
+    const ScopedLock sl(lock);
+    return maxBytes;
+}
+
+size_t SampleBlockCache::getCurrentBytes(){
+    const ScopedLock sl(lock);
+    return currentBytes;
+}
+
+CachedSampleBlock::Ptr SampleBlockCache::getBlock(int fileId, int blockIdx){
+
+    const ScopedLock sl(lock);
+
+    CachedSampleBlock::Ptr block = blocks[getKey(fileId, blockIdx)]; // nullptr if missing
+    if(block != nullptr){
+        block->lastUsed = ++tick;
+    }
+    return block;
+}
+
+bool SampleBlockCache::containsBlock(int fileId, int blockIdx){
+    const ScopedLock sl(lock);
+    return blocks.contains(getKey(fileId, blockIdx));
+}
+
+void SampleBlockCache::addBlock(int fileId, int blockIdx, CachedSampleBlock::Ptr block){
+
+    const ScopedLock sl(lock);
+
+    int64 key = getKey(fileId, blockIdx);
+    if(blocks.contains(key)){ // decoded twice, on demand and by a job
+        currentBytes -= blocks[key]->samples.getSizeInBytes();
+        blocks.remove(key);
+    }
+
+    size_t blockBytes = block->samples.getSizeInBytes();
+    evictToFit(blockBytes);
+
+    block->lastUsed = ++tick;
+    blocks.set(key, block);
+    currentBytes += blockBytes;
+}
+
+void SampleBlockCache::removeFile(int fileId){
+
+    const ScopedLock sl(lock);
+
+    Array<int64> keysToRemove;
+    for(HashMap<int64, CachedSampleBlock::Ptr>::Iterator i(blocks); i.next();){
+        if(int(i.getKey() >> 32) == fileId){
+            keysToRemove.add(i.getKey());
+        }
+    }
+
+    for(int i=0; i<keysToRemove.size(); i++){
+        currentBytes -= blocks[keysToRemove[i]]->samples.getSizeInBytes();
+        blocks.remove(keysToRemove[i]);
+    }
+}
+
+void SampleBlockCache::evictToFit(size_t newBytes){
+
+    // scanning is fine, the budget holds tens to hundreds of 2^20 sample blocks
+    while(currentBytes + newBytes > maxBytes and blocks.size() > 0){
+        int64 oldestKey = 0;
+        uint32 oldestAge = 0;
+
+        for(HashMap<int64, CachedSampleBlock::Ptr>::Iterator i(blocks); i.next();){
+            uint32 age = tick - i.getValue()->lastUsed; // wraps correctly
+            if(age >= oldestAge){
+                oldestAge = age;
+                oldestKey = i.getKey();
+            }
+        }
+
+        currentBytes -= blocks[oldestKey]->samples.getSizeInBytes();
+        blocks.remove(oldestKey);
+    }
+}
+
+int64 SampleBlockCache::getKey(int fileId, int blockIdx){
+    return (int64(fileId) << 32) | int64(uint32(blockIdx));
+}
@@ -0,0 +1,116 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef SAMPLEBLOCKCACHE_H_INCLUDED
+#define SAMPLEBLOCKCACHE_H_INCLUDED
+
+#include "JuceHeader.h"
+#include "CompactSampleBuffer.h"
+
+/*! one decoded block in the cache, reference counted so a reader can keep using it after it's evicted
+*/
+class CachedSampleBlock : public ReferenceCountedObject
+{
+public:
+    typedef ReferenceCountedObjectPtr<CachedSampleBlock> Ptr;
+
+    CachedSampleBlock(int numChannels, int numSamples, bool useInt16) : samples(numChannels, numSamples, useInt16), lastUsed(0) {}
+
+    CompactSampleBuffer samples;
+    uint32 lastUsed; // cache tick of last getBlock, for LRU
+};
+
+/*! decoded blocks of all files in the process, evicting the least recently used block when over the byte budget
+
+    Every SegaudioFile keeps its decoded samples here, so the budget is a ceiling for decoded audio no matter how
+    many or how long the files are. Memory mapped files are paged by the OS instead and don't use this.
+*/
+class SampleBlockCache
+{
+
+public:
+    SampleBlockCache();
+    ~SampleBlockCache();
+
+    /*! the cache shared by all files
+        @return SampleBlockCache&
+    */
+    static SampleBlockCache& getSharedCache();
+
+    /*! gets an id for a file's blocks, different for every call
+        @return int
+    */
+    int createFileId();
+
+    /*! sets the byte budget, evicts right away if over it
+        @param size_t newMaxBytes
+        @return void
+    */
+    void setMaxBytes(size_t newMaxBytes);
+    size_t getMaxBytes();
+    size_t getCurrentBytes();
+
+    /*! looks up a block and marks it as used
+        @param int fileId
+        @param int blockIdx
+        @return CachedSampleBlock::Ptr: nullptr if not cached
+    */
+    CachedSampleBlock::Ptr getBlock(int fileId, int blockIdx);
+
+    /*! check if a block is cached without marking it as used
+        @param int fileId
+        @param int blockIdx
+        @return bool
+    */
+    bool containsBlock(int fileId, int blockIdx);
+
+    /*! adds or replaces a block, evicting least recently used blocks to stay in budget
+        @param int fileId
+        @param int blockIdx
+        @param CachedSampleBlock::Ptr block
+        @return void
+    */
+    void addBlock(int fileId, int blockIdx, CachedSampleBlock::Ptr block);
+
+    /*! removes all blocks of a file
+        @param int fileId
+        @return void
+    */
+    void removeFile(int fileId);
+
+private:
+
+    /*! removes least recently used blocks until newBytes more fit in budget, call with lock held
+        @param size_t newBytes
+        @return void
+    */
+    void evictToFit(size_t newBytes);
+
+    static int64 getKey(int fileId, int blockIdx);
+
+    CriticalSection lock; // files are read from analysis, loader, decode and audio threads
+
+    HashMap<int64, CachedSampleBlock::Ptr> blocks;
+    size_t maxBytes;
+    size_t currentBytes;
+    uint32 tick; // incremented on every getBlock and addBlock
+    int nextFileId;
+};
+
+
+
+#endif  // SAMPLEBLOCKCACHE_H_INCLUDED
@@ -0,0 +1,285 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+/*
+    segaudio-cli: searches many target files for a region of a reference file without a GUI, see printUsage.
+*/
+
+#include "JuceHeader.h"
+#include "BatchSearch.h"
+#include <iostream>
+
+
+static void printUsage(){
+    std::cout <<
+    "usage: segaudio-cli --reference <file> [--range <start>:<end>] --output <folder> [options] [targets...]\n"
+    "\n"
+    "targets:\n"
+    "  <file> ...                 target files\n"
+    "  --targets <file>           text file with one target path per line\n"
+    "  --target-dir <folder>      every audio file in a folder\n"
+    "  --recursive                include sub folders of --target-dir\n"
+    "\n"
+    "reference:\n"
+    "  --range <start>:<end>      reference region in seconds, the whole file if not given\n"
+    "  --features <list>          comma separated rms,mfcc,zcr,sc (default mfcc)\n"
+    "\n"
+    "regions, from cluster parameters (0 to 1 like the sliders):\n"
+    "  --threshold <value>        (default 0.5)\n"
+    "  --connection <value>       smoothing between regions (default 0)\n"
+    "  --min-width <value>        shortest region as a fraction of the file (default 0)\n"
+    "  --max-width <value>        longest region as a fraction of the file (default 1)\n"
+    "  --invert                   keep what doesn't match instead\n"
+    "or from a search for each target:\n"
+    "  --search <regions>         number of regions to look for\n"
+    "  --search-percent <value>   how much of the file they make up (default 10)\n"
+    "\n"
+    "output:\n"
+    "  --format csv|jsonl|bin     region boundaries (default csv)\n"
+    "  --audio wav|flac|ogg       also export the regions\n"
+    "  --one-file                 regions of a target in one file\n"
+    "  --gap <seconds>            silence between regions in one file\n"
+    "  --crossfade <seconds>      overlap between regions in one file\n"
+    "  --threads <n>              targets searched at once (default one per core)\n";
+}
+
+/*! gets the value after an option, or prints an error
+    @param const StringArray &args
+    @param int &argIdx: index of the option, moved to the value
+    @param String &value: holds the value
+    @return bool: false if there is no value
+*/
+static bool getOptionValue(const StringArray &args, int &argIdx, String &value){
+    if(argIdx + 1 >= args.size()){
+        std::cerr << "missing value for " << args[argIdx] << std::endl;
+        return false;
+    }
+    value = args[++argIdx];
+    return true;
+}
+
+/*! prints each target as it finishes
+*/
+class ProgressPrinter : public BatchSearch::Listener
+{
+public:
+    ProgressPrinter(int totalNumTargets){
+        numTargets = totalNumTargets;
+        numPrinted = 0;
+    };
+
+    void targetSearched(BatchSearch* /*search*/, const TargetSearchResult &result){
+        numPrinted++; // calls come one at a time
+        std::cout << "[" << numPrinted << "/" << numTargets << "] " << result.targetFile.getFullPathName();
+        if(result.succeeded){
+            std::cout << ": " << result.numRegions << " regions";
+        }
+        else{
+            std::cout << ": failed, " << result.errorMessage;
+        }
+        std::cout << std::endl;
+    }
+
+private:
+    int numTargets;
+    int numPrinted;
+};
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    StringArray args;
+    for(int i=1; i<argc; i++){
+        args.add(String::fromUTF8(argv[i]));
+    }
+
+    if(args.size() == 0 or args.contains("--help") or args.contains("-h")){
+        printUsage();
+        return args.size() == 0 ? 2 : 0;
+    }
+
+    BatchSearchParameters params;
+    params.featuresToUse.mfcc = true;
+    params.clusterParams.threshold = 0.5;
+    params.clusterParams.regionConnectionWidth = 0;
+    params.searchParams.numRegions = 0;
+    params.searchParams.filePercentage = 0.1f;
+
+    StringArray targetPaths;
+    File targetListFile, targetDirectory;
+    bool recursive = false;
+    int numThreads = 0;
+    String value;
+
+    for(int i=0; i<args.size(); i++){
+        const String arg = args[i];
+
+        if(not arg.startsWith("--")){
+            targetPaths.add(arg);
+            continue;
+        }
+        if(arg == "--recursive"){
+            recursive = true;
+            continue;
+        }
+        if(arg == "--invert"){
+            params.clusterParams.shouldInvertRegions = true;
+            continue;
+        }
+        if(arg == "--one-file"){
+            params.exportParams.asOneFile = true;
+            continue;
+        }
+
+        // the rest take a value
+        if(not getOptionValue(args, i, value)){
+            return 2;
+        }
+
+        if(arg == "--reference"){
+            params.referenceFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        else if(arg == "--range"){
+            params.referenceStartSeconds = value.upToFirstOccurrenceOf(":", false, false).getDoubleValue();
+            params.referenceEndSeconds = value.fromFirstOccurrenceOf(":", false, false).getDoubleValue();
+        }
+        else if(arg == "--features"){
+            StringArray features;
+            features.addTokens(value, ",", String::empty);
+            params.featuresToUse = SignalFeaturesToUse();
+            params.featuresToUse.rms = features.contains("rms");
+            params.featuresToUse.mfcc = features.contains("mfcc");
+            params.featuresToUse.zcr = features.contains("zcr");
+            params.featuresToUse.sc = features.contains("sc");
+            if(params.featuresToUse.isNoneSelected()){
+                std::cerr << "no known features in " << value << std::endl;
+                return 2;
+            }
+        }
+        else if(arg == "--threshold"){
+            params.clusterParams.threshold = value.getFloatValue();
+        }
+        else if(arg == "--connection"){
+            params.clusterParams.regionConnectionWidth = value.getFloatValue();
+        }
+        else if(arg == "--min-width"){
+            params.clusterParams.minRegionTimeWidth = value.getFloatValue();
+        }
+        else if(arg == "--max-width"){
+            params.clusterParams.maxRegionTimeWidth = value.getFloatValue();
+        }
+        else if(arg == "--search"){
+            params.useSearch = true;
+            params.searchParams.numRegions = value.getIntValue();
+        }
+        else if(arg == "--search-percent"){
+            params.searchParams.filePercentage = value.getFloatValue() / 100.0f;
+        }
+        else if(arg == "--output"){
+            params.outputDirectory = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        else if(arg == "--format"){
+            if(value != "csv" and value != "jsonl" and value != "bin"){
+                std::cerr << "unknown boundary format " << value << std::endl;
+                return 2;
+            }
+            params.boundaryFormat = RegionBoundaryWriter::getFormatForFile(File("regions." + value));
+        }
+        else if(arg == "--audio"){
+            if(value != "wav" and value != "flac" and value != "ogg"){ // the exporter would write anything else as wav
+                std::cerr << "unknown audio format " << value << std::endl;
+                return 2;
+            }
+            params.exportAudio = true;
+            params.exportParams.formatExtension = value;
+        }
+        else if(arg == "--gap"){
+            params.exportParams.gapSeconds = value.getDoubleValue();
+        }
+        else if(arg == "--crossfade"){
+            params.exportParams.crossfadeSeconds = value.getDoubleValue();
+        }
+        else if(arg == "--threads"){
+            numThreads = value.getIntValue();
+        }
+        else if(arg == "--targets"){
+            targetListFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        else if(arg == "--target-dir"){
+            targetDirectory = File::getCurrentWorkingDirectory().getChildFile(value);
+        }
+        else{
+            std::cerr << "unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    if(params.referenceFile == File::nonexistent or params.outputDirectory == File::nonexistent){
+        std::cerr << "--reference and --output are needed" << std::endl;
+        return 2;
+    }
+
+    // search mode uses the width filter given for the cluster params
+    params.searchParams.useWidthFilter = (params.clusterParams.minRegionTimeWidth > 0 or params.clusterParams.maxRegionTimeWidth < 1);
+    params.searchParams.minWidth = params.clusterParams.minRegionTimeWidth;
+    params.searchParams.maxWidth = params.clusterParams.maxRegionTimeWidth;
+
+    // files and the engine post messages, nothing reads them here but there has to be a queue. No display is needed
+    MessageManager::getInstance();
+
+    int exitCode = 0;
+    {
+        BatchSearch search(params);
+
+        if(targetListFile != File::nonexistent){
+            StringArray listedPaths;
+            listedPaths.addLines(targetListFile.loadFileAsString());
+            listedPaths.removeEmptyStrings();
+            targetPaths.addArray(listedPaths);
+        }
+        for(int i=0; i<targetPaths.size(); i++){
+            search.addTarget(File::getCurrentWorkingDirectory().getChildFile(targetPaths[i].trim()));
+        }
+        if(targetDirectory != File::nonexistent){
+            search.addTargetsInDirectory(targetDirectory, recursive);
+        }
+
+        if(search.getNumTargets() == 0){
+            std::cerr << "no targets" << std::endl;
+            exitCode = 2;
+        }
+        else{
+            ProgressPrinter printer(search.getNumTargets());
+            search.addListener(&printer);
+
+            if(not search.run(numThreads)){
+                std::cerr << search.getErrorMessage() << std::endl;
+                exitCode = 2;
+            }
+            else{
+                std::cout << search.getNumSucceeded() << " of " << search.getNumTargets() << " targets searched" << std::endl;
+                exitCode = (search.getNumFailed() > 0) ? 1 : 0;
+            }
+
+            search.removeListener(&printer);
+        }
+    }
+
+    DeletedAtShutdown::deleteAll(); // JUCE singletons
+    MessageManager::deleteInstance();
+    return exitCode;
+}
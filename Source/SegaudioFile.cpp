@@ -17,51 +17,460 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "SegaudioFile.h"
 
-SegaudioFile::SegaudioFile(){
+/*! the decode pool of all files, deleted with JUCE's other singletons so its threads stop while JUCE is still up
+*/
+class SharedDecodePool : public ThreadPool,
+                         public DeletedAtShutdown
+{
+public:
+    SharedDecodePool() : ThreadPool(jmax(1, SystemStats::getNumCpus() - 1)){} // leave a core for the UI and playback
+
+    ~SharedDecodePool(){
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (SharedDecodePool, false)
+};
+
+juce_ImplementSingleton (SharedDecodePool)
+
+/*! the read-ahead thread of all transports, deleted with JUCE's other singletons like the decode pool
+*/
+class SharedReadAheadThread : public TimeSliceThread,
+                              public DeletedAtShutdown
+{
+public:
+    SharedReadAheadThread() : TimeSliceThread("SegaudioFile Read Ahead"){}
+
+    ~SharedReadAheadThread(){
+        clearSingletonInstance();
+    }
+
+    juce_DeclareSingleton (SharedReadAheadThread, false)
+};
+
+juce_ImplementSingleton (SharedReadAheadThread)
+
+SegaudioFile::SegaudioFile() : decodedChunkSize(1 << 20){
     
     formatManager.registerBasicFormats();
-    internalFileBuffer = new AudioSampleBuffer(2, 1);
     fileSet = false;
+    loadProgress = 0;
+    numListenedSamples = 0;
+    sampleStorage = automaticStorage;
+    storeAsInt16 = false;
+    numChunks = 0;
+    contentHash = 0;
+    cacheFileId = SampleBlockCache::getSharedCache().createFileId();
+
+    loaderThread = new LoaderThread(*this);
+    decodePool = &getDecodePool(); // after the cache, so it's destroyed first
+    fileSource = new FileSource(*this);
+
+    totalNumSamples = 0;
+    sampleRate = 0;
+    numChannels = 0;
+    bitsPerSample = 0;
 
 }
 
 SegaudioFile::~SegaudioFile(){
-    delete internalFileBuffer;
-    internalFileBuffer = nullptr;
+    cancelLoading(); // loader thread and decode jobs use this file
+    SampleBlockCache::getSharedCache().removeFile(cacheFileId);
+}
+
+void SegaudioFile::addListener(Listener* listener){
+    listeners.add(listener);
+}
+
+void SegaudioFile::addListenerWithLoadedSamples(Listener* listener){
+
+    const ScopedLock sl(listeners.getListeners().getLock()); // the loader thread calls the listeners under it
+    listeners.add(listener);
+
+    if(numListenedSamples == 0){
+        return;
+    }
+
+    AudioSampleBuffer block(numChannels, decodedChunkSize);
+    for(int64 chunkStart=0; chunkStart<numListenedSamples; chunkStart+=decodedChunkSize){
+        int chunkLength = int(jmin<int64>(decodedChunkSize, numListenedSamples - chunkStart));
+        block.setSize(numChannels, chunkLength, false, false, true);
+        readSamples(&block, 0, chunkStart, chunkLength); // decoded again if it was evicted
+        listener->samplesLoaded(this, block, chunkStart);
+    }
+}
+
+void SegaudioFile::removeListener(Listener* listener){
+    listeners.remove(listener); // waits for a callback in progress, listeners are locked while called
 }
 
 void SegaudioFile::setFile(File &newFile){
     
-    internalFile = &newFile;
+    cancelLoading(); // picking another file while one is still decoding
 
-    formatReader = formatManager.createReaderFor(*internalFile);
+    internalFile = newFile; // copy, newFile is usually a local from the file chooser
 
-    newFileSource = new AudioFormatReaderSource(formatReader, false);
+    SampleBlockCache::getSharedCache().removeFile(cacheFileId); // release the last decoded file
+    cacheFileId = SampleBlockCache::getSharedCache().createFileId(); // so stale chunks can never be found
 
-    internalFileBuffer->setSize(formatReader->numChannels, formatReader->lengthInSamples);
-    
-    totalNumSamples = formatReader->lengthInSamples;
-    sampleRate = formatReader->sampleRate;
-    numChannels = formatReader->numChannels;
-    
-    formatReader->read(internalFileBuffer, 0, formatReader->lengthInSamples, 0, true, true);
+    mappedReader = nullptr;
+    decodeReader = nullptr;
+    storeAsInt16 = false;
+    numChunks = 0;
+    numDecodedSamples = 0;
+    loadProgress = 0;
+    {
+        const ScopedLock sl(listeners.getListeners().getLock());
+        numListenedSamples = 0;
+    }
+    fileSet = false;
+    totalNumSamples = 0;
+    contentHash = 0;
+
+    // one reader per file, analysis, playback and the thumbnail all read from it
+    AudioFormatReader* reader = mappedReader = createMappedReader();
+    if(reader == nullptr){
+        reader = decodeReader = formatManager.createReaderFor(internalFile);
+    }
+    if(reader == nullptr){
+        return;
+    }
+
+    totalNumSamples = reader->lengthInSamples;
+    sampleRate = reader->sampleRate;
+    bitsPerSample = int(reader->bitsPerSample);
+    numChannels = reader->numChannels;
+    contentHash = FileFingerprint::calculate(internalFile);
+
+    if(mappedReader != nullptr){
+        numDecodedSamples = totalNumSamples; // nothing to decode, all samples readable
+    }
+    else{ // compressed formats have to be decoded, a chunk at a time on the loader thread
+        if(sampleStorage == automaticStorage){ // 16 bit samples fit exactly
+            storeAsInt16 = (decodeReader->bitsPerSample <= 16 and not decodeReader->usesFloatingPointData);
+        }
+        else{
+            storeAsInt16 = (sampleStorage == int16Storage);
+        }
+
+        numChunks = int((totalNumSamples + decodedChunkSize - 1) / decodedChunkSize);
+        isChunkDecoded.clearQuick();
+        isChunkDecoded.insertMultiple(0, Atomic<int>(0), numChunks);
+    }
     
     fileSet = true;
 }
 
+void SegaudioFile::startLoading(){
+
+    if(not fileSet){
+        return;
+    }
+
+    loaderThread->startThread();
+
+    if(mappedReader != nullptr){
+        sendActionMessage("fileLoaded"); // readable already, loader thread only feeds the listeners
+    }
+}
+
+bool SegaudioFile::loadOnCallingThread(){
 
-AudioSampleBuffer* SegaudioFile::getFileBuffer(){
-    if(fileSet){
-        return internalFileBuffer;
+    if(not fileSet){
+        return false;
     }
-    return NULL;
+
+    AudioSampleBuffer block(numChannels, decodedChunkSize); // float samples for the listeners
+    int numBlocks = int((totalNumSamples + decodedChunkSize - 1) / decodedChunkSize);
+
+    for(int chunkIdx=0; chunkIdx<numBlocks; chunkIdx++){
+
+        int64 chunkStart = int64(chunkIdx) * decodedChunkSize;
+        int chunkLength = int(jmin<int64>(decodedChunkSize, totalNumSamples - chunkStart));
+
+        if(mappedReader == nullptr and isChunkDecoded.getReference(chunkIdx).get() == 0){
+            getDecodedChunk(chunkIdx); // into the cache, decoded again from there if it's evicted
+            isChunkDecoded.getReference(chunkIdx) = 1;
+        }
+
+        {
+            const ScopedLock sl(listeners.getListeners().getLock());
+            if(not listeners.isEmpty()){
+                block.setSize(numChannels, chunkLength, false, false, true);
+                readSamples(&block, 0, chunkStart, chunkLength);
+                listeners.call(&Listener::samplesLoaded, this, block, chunkStart);
+            }
+            numListenedSamples = chunkStart + chunkLength;
+        }
+
+        numDecodedSamples = chunkStart + chunkLength;
+        loadProgress = double(chunkStart + chunkLength) / totalNumSamples;
+    }
+
+    return true;
+}
+
+void SegaudioFile::cancelLoading(){
+    loaderThread->stopThread(10000); // checks threadShouldExit between chunks
+    DecodeJobSelector thisFilesJobs(this);
+    decodePool->removeAllJobs(true, 10000, &thisFilesJobs); // jobs check shouldExit between chunks
+
+    const ScopedLock sl(prefetchLock);
+    queuedChunks.clearQuick();
+}
+
+bool SegaudioFile::isFullyLoaded(){
+    return fileSet and numDecodedSamples.get() == totalNumSamples;
+}
+
+double& SegaudioFile::getLoadProgress(){
+    return loadProgress;
 }
 
-AudioFormatReaderSource* SegaudioFile::getSource(){
-    return newFileSource;
+void SegaudioFile::loadSamples(){
+
+    AudioSampleBuffer block(numChannels, decodedChunkSize); // float samples for the listeners
+    int numBlocks = int((totalNumSamples + decodedChunkSize - 1) / decodedChunkSize);
+
+    if(mappedReader == nullptr){ // start decoding, interleaved over the decode threads
+        int numJobs = jmax(1, jmin(decodePool->getNumThreads(), numChunks));
+        for(int i=0; i<numJobs; i++){
+            decodePool->addJob(new DecodeJob(*this, i, numJobs, true), true);
+        }
+    }
+
+    for(int chunkIdx=0; chunkIdx<numBlocks; chunkIdx++){
+
+        if(loaderThread->threadShouldExit()){ // another file picked or closing
+            return;
+        }
+
+        int64 chunkStart = int64(chunkIdx) * decodedChunkSize;
+        int chunkLength = int(jmin<int64>(decodedChunkSize, totalNumSamples - chunkStart));
+
+        if(mappedReader == nullptr){
+            while(isChunkDecoded.getReference(chunkIdx).get() == 0){ // chunks finish out of order
+                if(loaderThread->threadShouldExit()){
+                    return;
+                }
+                chunkDecodedEvent.wait(100);
+            }
+        }
+
+        block.setSize(numChannels, chunkLength, false, false, true);
+        readSamples(&block, 0, chunkStart, chunkLength); // just decoded, so almost always cached
+        {
+            const ScopedLock sl(listeners.getListeners().getLock()); // a listener being added gets the blocks up to here
+            listeners.call(&Listener::samplesLoaded, this, block, chunkStart);
+            numListenedSamples = chunkStart + chunkLength;
+        }
+
+        numDecodedSamples = chunkStart + chunkLength;
+        loadProgress = double(chunkStart + chunkLength) / totalNumSamples;
+    }
+
+    if(mappedReader == nullptr){
+        sendActionMessage("fileLoaded");
+    }
 }
 
-int SegaudioFile::getNumSamples(){
+ThreadPoolJob::JobStatus SegaudioFile::DecodeJob::runJob(){
+
+    ScopedPointer<AudioFormatReader> jobReader = file->formatManager.createReaderFor(file->internalFile); // readers can't seek from several threads
+    AudioSampleBuffer decodeBuffer(file->numChannels, file->decodedChunkSize); // readers decode to float
+
+    for(; chunkIdx<file->numChunks; chunkIdx+=chunkStep){
+
+        if(shouldExit()){ // another file picked or closing
+            return jobHasFinished;
+        }
+
+        if(jobReader != nullptr and not SampleBlockCache::getSharedCache().containsBlock(file->cacheFileId, chunkIdx)){
+            file->decodeChunk(jobReader, decodeBuffer, chunkIdx);
+        }
+
+        if(isLoadingJob){ // also when the reader failed, readSamples decodes it then
+            file->isChunkDecoded.getReference(chunkIdx) = 1;
+            file->chunkDecodedEvent.signal();
+        }
+        else{
+            const ScopedLock sl(file->prefetchLock);
+            file->queuedChunks.removeFirstMatchingValue(chunkIdx);
+        }
+    }
+
+    return jobHasFinished;
+}
+
+CachedSampleBlock::Ptr SegaudioFile::decodeChunk(AudioFormatReader* reader, AudioSampleBuffer &decodeBuffer, int chunkIdx){
+
+    int64 chunkStart = int64(chunkIdx) * decodedChunkSize;
+    int chunkLength = int(jmin<int64>(decodedChunkSize, totalNumSamples - chunkStart));
+
+    reader->read(&decodeBuffer, 0, chunkLength, chunkStart, true, true); // FLAC and Ogg readers seek to exact samples
+
+    CachedSampleBlock::Ptr chunk = new CachedSampleBlock(numChannels, chunkLength, storeAsInt16);
+    chunk->samples.writeFrom(decodeBuffer, chunkLength);
+
+    SampleBlockCache::getSharedCache().addBlock(cacheFileId, chunkIdx, chunk);
+    return chunk;
+}
+
+CachedSampleBlock::Ptr SegaudioFile::getDecodedChunk(int chunkIdx){
+
+    CachedSampleBlock::Ptr chunk = SampleBlockCache::getSharedCache().getBlock(cacheFileId, chunkIdx);
+    if(chunk != nullptr){
+        return chunk;
+    }
+
+    const ScopedLock sl(decodeLock);
+
+    chunk = SampleBlockCache::getSharedCache().getBlock(cacheFileId, chunkIdx); // decoded while waiting for the lock?
+    if(chunk == nullptr){
+        AudioSampleBuffer decodeBuffer(numChannels, decodedChunkSize);
+        chunk = decodeChunk(decodeReader, decodeBuffer, chunkIdx);
+    }
+    return chunk;
+}
+
+AudioFormatReader* SegaudioFile::createReader(){
+
+    if(not fileSet){
+        return nullptr;
+    }
+    return formatManager.createReaderFor(internalFile);
+}
+
+void SegaudioFile::prefetch(int64 startSample, int64 numSamples){
+
+    if(not fileSet or mappedReader != nullptr or numSamples <= 0){ // the OS pages memory mapped files
+        return;
+    }
+
+    const int maxPrefetchChunks = 2;
+    int firstChunk = int(jlimit<int64>(0, numChunks, startSample / decodedChunkSize));
+    int endChunk = int(jlimit<int64>(0, numChunks, (startSample + numSamples + decodedChunkSize - 1) / decodedChunkSize));
+    endChunk = jmin(endChunk, firstChunk + maxPrefetchChunks);
+
+    const ScopedLock sl(prefetchLock);
+
+    for(int chunkIdx=firstChunk; chunkIdx<endChunk; chunkIdx++){
+        if(not queuedChunks.contains(chunkIdx) and not SampleBlockCache::getSharedCache().containsBlock(cacheFileId, chunkIdx)){
+            queuedChunks.add(chunkIdx);
+            decodePool->addJob(new DecodeJob(*this, chunkIdx, numChunks, false), true);
+        }
+    }
+}
+
+ThreadPool& SegaudioFile::getDecodePool(){
+    return *SharedDecodePool::getInstance();
+}
+
+TimeSliceThread& SegaudioFile::getReadAheadThread(){
+    TimeSliceThread* readAheadThread = SharedReadAheadThread::getInstance();
+    if(not readAheadThread->isThreadRunning()){
+        readAheadThread->startThread(8); // above the decode threads, below the audio callback
+    }
+    return *readAheadThread;
+}
+
+void SegaudioFile::releaseCachedSamples(){
+    SampleBlockCache::getSharedCache().removeFile(cacheFileId);
+}
+
+MemoryMappedAudioFormatReader* SegaudioFile::createMappedReader(){
+
+    AudioFormat* format = formatManager.findFormatForFileExtension(internalFile.getFileExtension());
+    if(format == nullptr){
+        return nullptr;
+    }
+
+    ScopedPointer<MemoryMappedAudioFormatReader> reader = format->createMemoryMappedReader(internalFile); // nullptr if format can't map
+    if(reader == nullptr or not reader->mapEntireFile()){
+        return nullptr;
+    }
+
+    return reader.release();
+}
+
+void SegaudioFile::readSamples(AudioSampleBuffer* destBuffer, int destStartSample, int64 sourceStartSample, int numSamples){
+
+    if(not fileSet or numSamples <= 0){
+        destBuffer->clear(destStartSample, jmax(0, numSamples));
+        return;
+    }
+
+    if(mappedReader != nullptr){ // pages are only loaded as they are touched
+        mappedReader->read(destBuffer, destStartSample, numSamples, sourceStartSample, true, true);
+        return;
+    }
+
+    // decoded chunks, copy what's in range and zero the rest
+    destBuffer->clear(destStartSample, numSamples);
+
+    int numChannelsToCopy = jmin(destBuffer->getNumChannels(), numChannels);
+    int64 sourceSample = jmax<int64>(0, sourceStartSample);
+    int64 sourceEndSample = jmin(sourceStartSample + numSamples, totalNumSamples);
+
+    while(sourceSample < sourceEndSample){ // a window can span chunk boundaries
+        int chunkIdx = int(sourceSample / decodedChunkSize);
+        int sampleInChunk = int(sourceSample % decodedChunkSize);
+        int numToCopy = int(jmin<int64>(decodedChunkSize - sampleInChunk, sourceEndSample - sourceSample));
+        int destSample = destStartSample + int(sourceSample - sourceStartSample);
+
+        if(isChunkDecoded.getReference(chunkIdx).get() == 0){ // still loading, silence rather than blocking playback
+            sourceSample += numToCopy;
+            continue;
+        }
+
+        CachedSampleBlock::Ptr chunk = getDecodedChunk(chunkIdx); // kept alive even if evicted meanwhile
+
+        for(int j=0; j<numChannelsToCopy; j++){
+            chunk->samples.readInto(destBuffer, j, destSample, j, sampleInChunk, numToCopy);
+        }
+        if(numChannels == 1 and destBuffer->getNumChannels() > 1){ // mono to both sides, same as AudioFormatReader::read
+            chunk->samples.readInto(destBuffer, 1, destSample, 0, sampleInChunk, numToCopy);
+        }
+
+        sourceSample += numToCopy;
+    }
+
+    if(isFullyLoaded()){ // reads are mostly sequential, have the next chunk ready. Loading decodes them already
+        prefetch(sourceEndSample, 1);
+    }
+}
+
+void SegaudioFile::setSampleStorage(SampleStorage newStorage){
+    sampleStorage = newStorage;
+}
+
+bool SegaudioFile::isStoredAsInt16(){
+    return storeAsInt16;
+}
+
+bool SegaudioFile::isMemoryMapped(){
+    return mappedReader != nullptr;
+}
+
+bool SegaudioFile::isFileSet(){
+    return fileSet;
+}
+
+File SegaudioFile::getFile(){
+    return internalFile;
+}
+
+uint64 SegaudioFile::getContentHash(){
+    return contentHash;
+}
+
+
+PositionableAudioSource* SegaudioFile::getSource(){
+    return fileSource;
+}
+
+int64 SegaudioFile::getNumSamples(){
     return totalNumSamples;
 }
 
@@ -69,6 +478,10 @@ int SegaudioFile::getNumChannels(){
     return numChannels;
 }
 
-int SegaudioFile::getSampleRate(){
+int SegaudioFile::getBitsPerSample(){
+    return bitsPerSample;
+}
+
+double SegaudioFile::getSampleRate(){
     return sampleRate;
-}
\ No newline at end of file
+}
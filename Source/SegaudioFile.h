@@ -20,54 +20,339 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "JuceHeader.h"
 #include "AudioRegion.h"
+#include "CompactSampleBuffer.h"
+#include "SampleBlockCache.h"
+#include "FileFingerprint.h"
 
 /*! wrapper for Juce file to hide away some of the logic for getting file info
 
+    WAV and AIFF files are memory mapped instead of decoded, so opening them is quick and only the pages that are
+    read take memory. Other formats are decoded into chunks, since an AudioSampleBuffer can't hold more than 2^31
+    samples. Decoding runs on a pool of decode threads shared by all files, each job with its own reader, and the loader thread passes chunks
+    on in order as soon as they're decoded, sending "fileLoaded" when finished. Use readSamples to get samples
+    either way.
+
+    Decoded chunks live in the SampleBlockCache shared by all files, so decoded audio stays under one byte budget.
+    Chunks that were evicted are decoded again when read, and reading a chunk prefetches the next one.
+
+    Decoded samples can be kept as int16 instead of float (see setSampleStorage), halving their memory.
+
+    The file is only read once: the loader thread hands every block to the Listeners (the waveform thumbnail), and
+    playback and analysis read the same samples through getSource and readSamples.
 */
-class SegaudioFile : public File
+class SegaudioFile : public File,
+                     public ActionBroadcaster
 {
   
 public:
     SegaudioFile();
     ~SegaudioFile();
 
-    /*! sets the internal file
+    /*! gets each block of samples as the loader thread reads it
+    */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        /*! called on the loader thread for each block, in order from the start of the file. Blocks loaded before
+            addListenerWithLoadedSamples are passed on the thread calling it
+            @param SegaudioFile* file: file the block is from
+            @param const AudioSampleBuffer &block: samples, only valid during the call
+            @param int64 startSample: position of the block in the file
+            @return void
+        */
+        virtual void samplesLoaded(SegaudioFile* file, const AudioSampleBuffer &block, int64 startSample) = 0;
+    };
+
+    void addListener(Listener* listener);
+    void removeListener(Listener* listener);
+
+    /*! adds a listener and first passes it the blocks the other listeners got already, read from the cache or the
+        map on the calling thread. The loader thread waits meanwhile, so every block reaches the listener once
+        @param Listener* listener
+        @return void
+    */
+    void addListenerWithLoadedSamples(Listener* listener);
+
+    /*! how decoded samples are kept in memory, memory mapped files aren't decoded so this doesn't apply to them
+    */
+    enum SampleStorage{
+        automaticStorage, // int16 for sources of 16 bits or less, float otherwise
+        floatStorage,
+        int16Storage
+    };
+
+    /*! sets how samples are kept, used from the next setFile
+        @param SampleStorage newStorage
+        @return void
+    */
+    void setSampleStorage(SampleStorage newStorage);
+
+    /*! check if the decoded samples are kept as int16
+        @return bool
+    */
+    bool isStoredAsInt16();
+
+    /*! sets the internal file and cancels loading the last one, info like getNumSamples is available after this
         @param File &newFile
         @return void
     */
     void setFile(File &newFile);
 
-    /*! gets the samples in a buffer
-        @return AudioSampleBuffer*
+    /*! starts the loader thread, call after the listeners for this file are set up so they get every block
+        @return void
+    */
+    void startLoading();
+
+    /*! decodes the whole file before returning, for the batch search where nothing waits for the loader thread.
+        Listeners get every block like with startLoading, but there is no "fileLoaded" message. Don't use both
+        @return bool: false if no file is set
+    */
+    bool loadOnCallingThread();
+
+    /*! stops the loader thread, samples not decoded yet read as 0
+        @return void
+    */
+    void cancelLoading();
+
+    /*! check if all samples can be read, always true for memory mapped files
+        @return bool
+    */
+    bool isFullyLoaded();
+
+    /*! gets the fraction of the file decoded, for a ProgressBar
+        @return double&: 0 to 1, stays valid for the life of this object
+    */
+    double& getLoadProgress();
+
+    /*! copies a window of samples from the file, samples past the end or not decoded yet are set to 0. Only reads, so can be called
+        from the analysis thread while the message thread reads too
+        @param AudioSampleBuffer* destBuffer: holds the samples, needs at least numSamples from destStartSample
+        @param int destStartSample: where to start in destBuffer
+        @param int64 sourceStartSample: where to start in file
+        @param int numSamples: number of samples to copy
+        @return void
+    */
+    void readSamples(AudioSampleBuffer* destBuffer, int destStartSample, int64 sourceStartSample, int numSamples);
+
+    /*! creates a reader of its own for the file, for streaming through it once without going through the cache
+        @return AudioFormatReader*: caller owns it, nullptr if no file is set or it can't be read
+    */
+    AudioFormatReader* createReader();
+
+    /*! hints that samples will be read soon, decodes the chunks that aren't cached on the decode threads
+        @param int64 startSample
+        @param int64 numSamples: only the first few chunks are prefetched, so they don't evict each other
+        @return void
+    */
+    void prefetch(int64 startSample, int64 numSamples);
+
+    /*! drops this file's decoded chunks from the cache, they're decoded again when read. For files that aren't
+        being looked at, so other files keep theirs
+        @return void
     */
-    AudioSampleBuffer* getFileBuffer();
+    void releaseCachedSamples();
 
-    /*! gets a format source for the file, used by various other components in the application
-        @return AudioFormatReaderSource*
+    /*! check if samples are read from a memory mapped file instead of a decoded buffer
+        @return bool
     */
-    AudioFormatReaderSource* getSource();
+    bool isMemoryMapped();
+
+    /*! gets a source for the audio transport, reading the same samples as readSamples. Give the transport
+        readAheadSamples and getReadAheadThread, so reads from disk or decoding an evicted chunk don't happen on the
+        audio callback
+        @return PositionableAudioSource*
+    */
+    PositionableAudioSource* getSource();
+
+    /*! gets the thread that fills the playback buffers, shared by the transports of all components
+        @return TimeSliceThread&
+    */
+    static TimeSliceThread& getReadAheadThread();
+
+    static const int readAheadSamples = 1 << 16; // playback buffer, about 1.5s at 44.1kHz for slow network storage
     
-    int getNumSamples();
-    int getSampleRate();
+    bool isFileSet();
+    File getFile();
+
+    /*! gets the content hash of the file, the same after renaming or moving it. For keying caches of features,
+        thumbnails and distances
+        @return uint64: 0 if no file is set, see FileFingerprint
+    */
+    uint64 getContentHash();
+
+    int64 getNumSamples();
+    double getSampleRate();
     int getNumChannels();
+    int getBitsPerSample();
     
     
 private:
     
     bool fileSet; // whether a file is set
     
-    File* internalFile;
-    AudioSampleBuffer* internalFileBuffer;
+    File internalFile;
+    uint64 contentHash; // from a few small reads in setFile, not a pass over the file
+    int cacheFileId; // decoded chunks are in the shared SampleBlockCache under this id
+    int numChunks; // decodedChunkSize each, 0 if memory mapped
+    SampleStorage sampleStorage;
+    bool storeAsInt16; // for the file that is set
+    const int decodedChunkSize;
+    Atomic<int64> numDecodedSamples; // samples before this can be read
+    double loadProgress; // read by the ProgressBar in the file components
+    int64 numListenedSamples; // samples before this were passed to the listeners, under the listeners' lock
     
     AudioFormatManager formatManager;  // used for getting a reader
 
-    ScopedPointer<AudioFormatReader> formatReader; // for reading the file
+    ScopedPointer<MemoryMappedAudioFormatReader> mappedReader; // for readSamples on WAV and AIFF, nullptr if decoded
+    ScopedPointer<AudioFormatReader> decodeReader; // decodes chunks missing from the cache in readSamples, nullptr if memory mapped
+    CriticalSection decodeLock; // guards decodeReader
+
+    ThreadPool* decodePool; // decodes chunks in parallel for loading and prefetching, shared by all files
+    Array<Atomic<int> > isChunkDecoded; // set by the loading decode jobs, 1 when chunk i was decoded or failed
+    WaitableEvent chunkDecodedEvent; // wakes the loader thread when a job finished a chunk
+
+    CriticalSection prefetchLock; // guards queuedChunks
+    Array<int> queuedChunks; // chunks with a prefetch job waiting, so they aren't queued twice
+
+    /*! gets the decode pool, one for all files so loading many targets doesn't start a pool each. It's deleted by
+        DeletedAtShutdown::deleteAll, after all files
+        @return ThreadPool&
+    */
+    static ThreadPool& getDecodePool();
+
+    /*! gets a decoded chunk from the cache, decoding it now if it isn't cached
+        @param int chunkIdx
+        @return CachedSampleBlock::Ptr
+    */
+    CachedSampleBlock::Ptr getDecodedChunk(int chunkIdx);
+
+    /*! decodes a chunk and adds it to the cache
+        @param AudioFormatReader* reader: reader to use, only from one thread at a time
+        @param AudioSampleBuffer &decodeBuffer: float buffer of at least decodedChunkSize, readers decode to float
+        @param int chunkIdx
+        @return CachedSampleBlock::Ptr
+    */
+    CachedSampleBlock::Ptr decodeChunk(AudioFormatReader* reader, AudioSampleBuffer &decodeBuffer, int chunkIdx);
+
+    /*! decodes every chunkStep-th chunk from firstChunk with its own reader. Loading interleaves the jobs so the
+        chunks at the start are done first, a prefetch job decodes one chunk
+    */
+    class DecodeJob : public ThreadPoolJob
+    {
+    public:
+
+        DecodeJob(SegaudioFile &fileToDecode, int firstChunk, int step, bool isLoading) : ThreadPoolJob("SegaudioFile Decode"){
+            file = &fileToDecode;
+            chunkIdx = firstChunk;
+            chunkStep = step;
+            isLoadingJob = isLoading;
+        };
+
+        JobStatus runJob();
+
+        bool isDecoding(SegaudioFile* fileToCheck){ return file == fileToCheck; }
+
+    private:
+        SegaudioFile* file;
+        int chunkIdx;
+        int chunkStep;
+        bool isLoadingJob; // sets isChunkDecoded, otherwise removes the chunk from queuedChunks
+
+    };
+
+    /*! picks this file's jobs from the shared decode pool
+    */
+    class DecodeJobSelector : public ThreadPool::JobSelector
+    {
+    public:
+        DecodeJobSelector(SegaudioFile* fileToSelect){
+            file = fileToSelect;
+        };
+
+        bool isJobSuitable(ThreadPoolJob* job){
+            DecodeJob* decodeJob = dynamic_cast<DecodeJob*>(job);
+            return decodeJob != nullptr and decodeJob->isDecoding(file);
+        }
+
+    private:
+        SegaudioFile* file;
+
+    };
+
+    ListenerList<Listener, Array<Listener*, CriticalSection> > listeners; // locked, called from the loader thread
+
+    /*! decodes the file into the cache or reads it from the map, passing every block to the listeners,
+        called on the loader thread
+        @return void
+    */
+    void loadSamples();
+
+    class LoaderThread : public Thread
+    {
+    public:
+
+        LoaderThread(SegaudioFile &fileToLoad) : Thread("SegaudioFile Loader"){
+            file = &fileToLoad;
+        };
+
+        ~LoaderThread(){
+            stopThread(10000);
+        };
+
+        virtual void run(){
+            file->loadSamples();
+        }
+
+    private:
+        SegaudioFile* file;
+
+    };
+
+    ScopedPointer<LoaderThread> loaderThread;
+
+    /*! creates a memory mapped reader for the whole file if the format supports it
+        @return MemoryMappedAudioFormatReader*: nullptr if not WAV or AIFF or mapping failed
+    */
+    MemoryMappedAudioFormatReader* createMappedReader();
+
+    /*! plays the samples of a SegaudioFile, so playback doesn't need its own reader
+    */
+    class FileSource : public PositionableAudioSource
+    {
+    public:
+
+        FileSource(SegaudioFile &sourceFile){
+            file = &sourceFile;
+            readPosition = 0;
+        };
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate){};
+        void releaseResources(){};
+
+        void getNextAudioBlock(const AudioSourceChannelInfo &bufferToFill){
+            file->readSamples(bufferToFill.buffer, bufferToFill.startSample, readPosition, bufferToFill.numSamples);
+            readPosition += bufferToFill.numSamples;
+        }
+
+        void setNextReadPosition(int64 newPosition){ readPosition = newPosition; }
+        int64 getNextReadPosition() const { return readPosition; }
+        int64 getTotalLength() const { return file->getNumSamples(); }
+        bool isLooping() const { return false; }
+
+    private:
+        SegaudioFile* file;
+        int64 readPosition;
+
+    };
 
-    ScopedPointer<AudioFormatReaderSource> newFileSource; // used by audio transport
+    ScopedPointer<FileSource> fileSource; // used by audio transport
     
-    int totalNumSamples;
-    int sampleRate;
+    int64 totalNumSamples;
+    double sampleRate;
     int numChannels;
+    int bitsPerSample; // of the source, kept when exporting
 };
 
 
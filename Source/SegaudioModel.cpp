@@ -21,7 +21,11 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 SegaudioModel::SegaudioModel(int maxFiles) :
     maxFiles(maxFiles)
 {
-    // TODO set max files here?
+    refFile = nullptr;
+    activeTime = 0;
+
+    activeTarget = targets.add(new TargetAnalysis());
+    activeTarget->id = "1";
 }
 
 SegaudioModel::~SegaudioModel(){
@@ -29,19 +33,103 @@ SegaudioModel::~SegaudioModel(){
 }
 
 bool SegaudioModel::addFile(SegaudioFile* newFile, String componentId){
-        
-//    if(files.getNumSlots() == 0){
-//        return false;
-//    }
-    
+
     if(componentId == "0"){
         refFile = newFile;
+        return true;
+    }
+
+    TargetAnalysis* target = getTarget(componentId);
+    if(target == nullptr){
+        target = targets.add(new TargetAnalysis());
+        target->id = componentId;
+    }
+    target->file.set(newFile, false);
+
+    return true;
+}
+
+SegaudioFile* SegaudioModel::addTargetFile(File &file){
+
+    TargetAnalysis* target = getTarget(file.getFullPathName());
+    if(target == nullptr){
+        target = targets.add(new TargetAnalysis());
+        target->id = file.getFullPathName();
+        target->file.setOwned(new SegaudioFile());
+        target->file->setFile(file);
+    }
+
+    return target->file;
+}
+
+void SegaudioModel::removeTargets(){
+
+    activeTarget = targets.getFirst();
+    targets.removeRange(1, targets.size() - 1);
+    clearTargetRegions();
+}
+
+StringArray SegaudioModel::getTargetIds(){
+
+    StringArray targetIds;
+    for(int i=0; i<targets.size(); i++){
+        targetIds.add(targets[i]->id);
+    }
+    return targetIds;
+}
+
+TargetAnalysis* SegaudioModel::getTarget(String targetId){
+
+    for(int i=0; i<targets.size(); i++){
+        if(targets[i]->id == targetId){
+            return targets[i];
+        }
     }
-    else if(componentId == "1"){
-        targetFile = newFile;
+    return nullptr;
+}
+
+bool SegaudioModel::setActiveTarget(String targetId){
+
+    TargetAnalysis* target = getTarget(targetId);
+    if(target == nullptr){
+        return false;
+    }
+
+    activeTarget = target;
+    activeTarget->lastActiveTime = ++activeTime;
+
+    // targets looked at less recently than the last maxFiles give their decoded samples back
+    for(int i=0; i<targets.size(); i++){
+        TargetAnalysis* other = targets[i];
+        if(other->file == nullptr or activeTime - other->lastActiveTime < uint32(maxFiles)){
+            continue;
+        }
+        if(other->file != refFile){ // the reference is read for every target
+            other->file->releaseCachedSamples();
+        }
     }
 
-//    files.set(componentId, newFile);
+    return true;
+}
+
+String SegaudioModel::getActiveTargetId(){
+    return activeTarget->id;
+}
+
+void SegaudioModel::setMemoryBudget(size_t maxBytes){
+    SampleBlockCache::getSharedCache().setMaxBytes(maxBytes);
+}
+
+bool SegaudioModel::areFilesLoaded(){
+
+    if(refFile == nullptr or not refFile->isFullyLoaded()){
+        return false;
+    }
+    for(int i=0; i<targets.size(); i++){
+        if(targets[i]->file == nullptr or not targets[i]->file->isFullyLoaded()){
+            return false;
+        }
+    }
     return true;
 }
 
@@ -54,19 +142,23 @@ void SegaudioModel::setClusterParams(ClusterParameters newParams){
 }
 
 void SegaudioModel::setDistanceArray(Array<float> distanceArray){
-    distanceArray = distanceArray;
+    activeTarget->distanceArray = distanceArray;
 }
 
 Array<float>* SegaudioModel::getDistanceArray(){
-    return &distanceArray;
+    return &activeTarget->distanceArray;
+}
+
+DistanceStatistics* SegaudioModel::getDistanceStatistics(){
+    return &activeTarget->distanceStatistics;
 }
 
 void SegaudioModel::setMaxDistance(float distance){
-    maxDistance = distance;
+    activeTarget->maxDistance = distance;
 }
 
 float* SegaudioModel::getMaxDistance(){
-    return &maxDistance;
+    return &activeTarget->maxDistance;
 }
 
 SegaudioFile* SegaudioModel::getSegaudioFile(String componentId){
@@ -74,12 +166,7 @@ SegaudioFile* SegaudioModel::getSegaudioFile(String componentId){
     return getFileById(componentId);
 }
 
-AudioSampleBuffer* SegaudioModel::getFileBuffer(String componentId){
-//    return files[componenetId]->getFileBuffer();
-    return getFileById(componentId)->getFileBuffer();
-}
-
-AudioFormatReaderSource* SegaudioModel::getFileSource(String componentId){
+PositionableAudioSource* SegaudioModel::getFileSource(String componentId){
 //    return files[componenetId]->getSource();
     return getFileById(componentId)->getSource();
 }
@@ -100,8 +187,10 @@ SegaudioFile* SegaudioModel::getFileById(String componentId){
     if(componentId == "0"){
         return refFile;
     }
-    else if(componentId == "1"){
-        return targetFile;
+
+    TargetAnalysis* target = getTarget(componentId);
+    if(target != nullptr){
+        return target->file;
     }
     
     return NULL;
@@ -112,10 +201,19 @@ Array<AudioRegion> *SegaudioModel::getReferenceRegions() {
 }
 
 Array<AudioRegion> *SegaudioModel::getTargetRegions() {
-    return &targetRegions;
+    return &activeTarget->regions;
 }
 
 void SegaudioModel::clearTargetRegions() {
-    targetRegions.clear();
-    distanceArray.clear();
+    activeTarget->regions.clear();
+    activeTarget->distanceArray.clear();
+    activeTarget->distanceStatistics.clear();
+}
+
+void SegaudioModel::clearAllTargetRegions() {
+    for(int i=0; i<targets.size(); i++){
+        targets[i]->regions.clear();
+        targets[i]->distanceArray.clear();
+        targets[i]->distanceStatistics.clear();
+    }
 }
@@ -21,6 +21,7 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 #include "JuceHeader.h"
 #include "SegaudioFile.h"
 #include "AudioRegion.h"
+#include "DistanceStatistics.h"
 
 /*! parameters that control how to calculate candidate regions
 
@@ -83,6 +84,9 @@ struct SignalFeaturesToUse{
 */
 struct ExportParameters{
     bool asOneFile = false; // combine all features into one file if true, separate files if not
+    String formatExtension = "wav"; // "wav", "flac" or "ogg"
+    double gapSeconds = 0; // silence between regions in one file
+    double crossfadeSeconds = 0; // overlap between regions in one file, only used without a gap
     Array<AudioRegion> clusterRegions;
 };
 
@@ -98,6 +102,25 @@ struct SearchParameters{
     float maxWidth = 1; // holds val from width filter if used
 };
 
+/*! one target file and everything calculated for it against the reference
+
+*/
+struct TargetAnalysis{
+    String id; // "1" for the file loaded in the target component, the file path for the rest
+    OptionalScopedPointer<SegaudioFile> file; // owned unless it came from a component
+    Array<float> distanceArray; // distances from similarity function
+    float maxDistance = 0; // max distance in distance array, used for scaling
+    DistanceStatistics distanceStatistics; // built once per calculation
+    Array<AudioRegion> regions; // regions found in this target
+    uint32 lastActiveTime = 0; // for releasing the decoded samples of targets not looked at for a while
+};
+
+/*! holds the reference and any number of targets, each with its own distances and regions
+
+    One target is active, the getters without a target id (getDistanceArray, getTargetRegions...) are for it. Target
+    "1" always exists, so pointers to its data stay valid. Decoded samples of all files share the budget set with
+    setMemoryBudget, and only the maxFiles most recently active targets keep theirs when the active target changes.
+*/
 class SegaudioModel
 {
 public:
@@ -105,12 +128,57 @@ public:
     SegaudioModel(int maxFiles);
     ~SegaudioModel();
 
-    /*! adds a new file with id
+    /*! adds a new file with id, the model doesn't own it
         @param SegaudioFile* newFile
-        @param String componentId: id associated with file for lookup
+        @param String componentId: "0" for the reference, anything else is a target
     */
     bool addFile(SegaudioFile* newFile, String componentId);
 
+    /*! adds a target the model owns, loading isn't started so listeners can be added first
+        @param File &file
+        @return SegaudioFile*: the file already added if it was added before
+    */
+    SegaudioFile* addTargetFile(File &file);
+
+    /*! removes all targets except "1", clearing its results
+        @return void
+    */
+    void removeTargets();
+
+    /*! gets the ids of all targets, "1" first
+        @return StringArray
+    */
+    StringArray getTargetIds();
+
+    /*! gets a target with its results
+        @param String targetId
+        @return TargetAnalysis*: nullptr if there's no target with that id
+    */
+    TargetAnalysis* getTarget(String targetId);
+
+    /*! makes a target the one the getters without id are for, releasing the decoded samples of targets that
+        weren't active for the longest
+        @param String targetId
+        @return bool: false if there's no target with that id
+    */
+    bool setActiveTarget(String targetId);
+
+    /*! gets the id of the active target
+        @return String
+    */
+    String getActiveTargetId();
+
+    /*! sets the byte budget for decoded samples of all files
+        @param size_t maxBytes
+        @return void
+    */
+    void setMemoryBudget(size_t maxBytes);
+
+    /*! check if the reference and every target can be read completely
+        @return bool
+    */
+    bool areFilesLoaded();
+
     /*! current application cluster parameters
         @return ClusterParameters*
     */
@@ -133,6 +201,11 @@ public:
     */
     Array<float>* getDistanceArray();
 
+    /*! gets range statistics over the current distance array, for scoring regions
+        @return DistanceStatistics*
+    */
+    DistanceStatistics* getDistanceStatistics();
+
     /*! sets new max distance of similarity function on the model
         @param float distance
         @return void
@@ -150,17 +223,11 @@ public:
     */
     SegaudioFile* getSegaudioFile(String componentId);
 
-    /*! gets file buffer for file with id
-        @param String componentId
-        @return AudioSampleBuffer*
-    */
-    AudioSampleBuffer* getFileBuffer(String componentId);
-
     /*! gets file source for file with id
         @param String componentId
-        @return AudioFormatReaderSource*
+        @return PositionableAudioSource*
     */
-    AudioFormatReaderSource* getFileSource(String componentId);
+    PositionableAudioSource* getFileSource(String componentId);
 
     /*! gets current signal features
         @return SignalFeaturesToUse*
@@ -197,21 +264,23 @@ public:
         @return void
     */
     void clearTargetRegions();
+
+    /*! clears regions and distances of every target, for a new reference
+        @return void
+    */
+    void clearAllTargetRegions();
     
 private:
         
-    int maxFiles; // not used right now, for handling multiple files later
+    int maxFiles; // targets that keep their decoded samples when another one becomes active
     
     ClusterParameters clusterParams; // parameters that calculate the clusters (regions) from the similarity function
-    
-    Array<float> distanceArray; // distances from similarity function
 
-    HashMap<String, SegaudioFile*> files; // not used right now, for handling multiple files later
-    
     SegaudioFile* refFile;
-    SegaudioFile* targetFile;
-    
-    float maxDistance; // max distance in distance array for similarity function, used for scaling
+
+    OwnedArray<TargetAnalysis> targets; // "1" first
+    TargetAnalysis* activeTarget;
+    uint32 activeTime; // counts setActiveTarget calls
     
     SignalFeaturesToUse featuresToUse; // which features used to calculate similarity function
     
@@ -220,7 +289,6 @@ private:
     SearchParameters searchParameters; // parameters for searching for matching clusters (regions)
 
     Array<AudioRegion> referenceRegions; // holds regions used as reference
-    Array<AudioRegion> targetRegions; // holds regions used for target
 };
 
 
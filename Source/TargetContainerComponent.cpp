@@ -87,7 +87,7 @@ void TargetContainer::resized()
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
-void TargetContainer::setFile(juce::File newFile){
+void TargetContainer::setFile(SegaudioFile* newFile){
     audioSelector->setFile(newFile);
 }
 void TargetContainer::setTuningParameters(ClusterParameters* clusterTuningParams, Array<float>* newDistances, float* maxDistance){
@@ -119,6 +119,10 @@ void TargetContainer::clearSimilarity(){
 void TargetContainer::setRegions(Array<AudioRegion> *regions_) {
     audioSelector->setRegions(regions_);
 }
+
+void TargetContainer::updateRegions() {
+    audioSelector->updateRegions();
+}
 //[/MiscUserCode]
 
 
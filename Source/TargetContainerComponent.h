@@ -52,7 +52,7 @@ public:
     // NOTE: These are all passthrough functions
     // I know there's probably a better way, but didn't have the time...
 
-    void setFile(File newFile);
+    void setFile(SegaudioFile* newFile);
 
     void setTuningParameters(ClusterParameters* clusterTuningParams, Array<float>* newDistances, float* maxDistance);
 
@@ -67,6 +67,8 @@ public:
 
     void setRegions(Array<AudioRegion>* regions_);
 
+    void updateRegions();
+
     //[/UserMethods]
 
     void paint (Graphics& g);
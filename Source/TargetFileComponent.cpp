@@ -83,6 +83,11 @@ TargetFileComponent::TargetFileComponent (AudioDeviceManager& deviceManager)
     container->addActionListener(this);
 
     currentFile = new SegaudioFile();
+    shownFile = nullptr;
+
+    addChildComponent(targetSelector = new ComboBox("targetSelector"));
+    targetSelector->setTextWhenNothingSelected("Targets");
+    targetSelector->addListener(this);
 
 
     //[/Constructor]
@@ -91,6 +96,9 @@ TargetFileComponent::TargetFileComponent (AudioDeviceManager& deviceManager)
 TargetFileComponent::~TargetFileComponent()
 {
     //[Destructor_pre]. You can add your own custom destruction code here..
+    if(shownFile != nullptr){
+        shownFile->removeActionListener(this); // might be owned by the model, which outlives this
+    }
     //[/Destructor_pre]
 
     viewport = nullptr;
@@ -130,6 +138,10 @@ void TargetFileComponent::resized()
     //[UserResized] Add your own custom resize handling here..
 
     container->setSize(getWidth(), getHeight());
+    if(loadProgressBar != nullptr){
+        loadProgressBar->setBounds(320, 16, 150, 24);
+    }
+    targetSelector->setBounds(320, 44, 150, 24);
 
     //[/UserResized]
 }
@@ -154,20 +166,18 @@ void TargetFileComponent::buttonClicked (Button* buttonThatWasClicked)
     else if (buttonThatWasClicked == loadFileButton)
     {
         //[UserButtonCode_loadFileButton] -- add your button handler code here..
-        FileChooser myChooser ("Please select the file you want to load...");
-        if (myChooser.browseForFileToOpen())
+        FileChooser myChooser ("Please select the files you want to load, the first one is shown...");
+        if (myChooser.browseForMultipleFilesToOpen())
         {
             audioTransport.setSource(nullptr); // this fixes memory issue with loading new file
 
-            File selectedFile = myChooser.getResult();
-            currentFile->setFile(selectedFile);
-
-            container->setFile(selectedFile);
+            selectedFiles = myChooser.getResults(); // the rest are added as targets on "setTargetFile"
+            File selectedFile = selectedFiles.getFirst();
+            currentFile->setFile(selectedFile); // cancels a file still loading
 
-            audioTransport.setSource(currentFile->getSource());
+            showFile(currentFile); // listens for the blocks before loading starts
+            currentFile->startLoading();
 
-            isPlayable = true;
-            setPlayable(true);
             sendActionMessage("setTargetFile");
 
         }
@@ -194,6 +204,14 @@ void TargetFileComponent::sliderValueChanged (Slider* sliderThatWasMoved)
     //[/UsersliderValueChanged_Post]
 }
 
+void TargetFileComponent::comboBoxChanged (ComboBox* comboBoxThatHasChanged)
+{
+    if (comboBoxThatHasChanged == targetSelector)
+    {
+        sendActionMessage("targetSelected");
+    }
+}
+
 
 
 //[MiscUserCode] You can add your own definitions of your custom methods or any other code here...
@@ -205,6 +223,43 @@ SegaudioFile* TargetFileComponent::getLoadedFile(){
     return currentFile;
 }
 
+Array<File> TargetFileComponent::getSelectedFiles(){
+    return selectedFiles;
+}
+
+void TargetFileComponent::showFile(SegaudioFile* file){
+
+    audioTransport.setSource(nullptr);
+
+    if(shownFile != nullptr){
+        shownFile->removeActionListener(this);
+    }
+    shownFile = file;
+    shownFile->addActionListener(this); // "fileLoaded" when decoding finishes
+
+    loadProgressBar = nullptr; // bound to the progress of one file
+    addChildComponent(loadProgressBar = new ProgressBar(shownFile->getLoadProgress()));
+    loadProgressBar->setBounds(320, 16, 150, 24);
+    loadProgressBar->setVisible(not shownFile->isFullyLoaded());
+
+    container->setFile(shownFile);
+    audioTransport.setSource(shownFile->getSource(), SegaudioFile::readAheadSamples, &SegaudioFile::getReadAheadThread()); // buffered, reads off the audio callback
+
+    isPlayable = true;
+    setPlayable(true);
+}
+
+void TargetFileComponent::setTargetNames(StringArray targetNames){
+    targetSelector->clear(dontSendNotification);
+    targetSelector->addItemList(targetNames, 1);
+    targetSelector->setSelectedItemIndex(0, dontSendNotification);
+    targetSelector->setVisible(targetNames.size() > 1);
+}
+
+int TargetFileComponent::getSelectedTargetIndex(){
+    return targetSelector->getSelectedItemIndex();
+}
+
 void TargetFileComponent::setPlayable(bool isPlayable){
     playButton->setEnabled(isPlayable);
     stopButton->setEnabled(isPlayable);
@@ -216,6 +271,13 @@ void TargetFileComponent::actionListenerCallback(const juce::String &message){
     if(message == "audioPositionUpdateWhilePlaying"){
         playAudio();
     }
+    else if(message == "fileLoaded"){
+        if(not shownFile->isFullyLoaded()){ // a late one from a file picked before, this one is still loading
+            return;
+        }
+        loadProgressBar->setVisible(false);
+        sendActionMessage("targetFileLoaded");
+    }
     else{
         sendActionMessage(message);
     }
@@ -242,6 +304,10 @@ void TargetFileComponent::setRegions(Array<AudioRegion> *regions_) {
     container->setRegions(regions_);
 }
 
+void TargetFileComponent::updateRegions() {
+    container->updateRegions();
+}
+
 //[/MiscUserCode]
 
 
@@ -255,7 +321,7 @@ void TargetFileComponent::setRegions(Array<AudioRegion> *regions_) {
 BEGIN_JUCER_METADATA
 
 <JUCER_COMPONENT documentType="Component" className="TargetFileComponent" componentName=""
-                 parentClasses="public Component, public ActionBroadcaster, public ActionListener"
+                 parentClasses="public Component, public ActionBroadcaster, public ActionListener, public ComboBoxListener"
                  constructorParams="AudioDeviceManager&amp; deviceManager" variableInitialisers="deviceManager(deviceManager)"
                  snapPixels="8" snapActive="1" snapShown="1" overlayOpacity="0.330"
                  fixedSize="0" initialWidth="600" initialHeight="400">
@@ -40,7 +40,8 @@ class TargetFileComponent  : public Component,
                              public ActionBroadcaster,
                              public ActionListener,
                              public ButtonListener,
-                             public SliderListener
+                             public SliderListener,
+                             public ComboBoxListener
 {
 public:
     //==============================================================================
@@ -67,6 +68,28 @@ public:
     */
     SegaudioFile* getLoadedFile();
 
+    /*! gets all files picked with the load button, the first one is the loaded file
+        @return Array<File>
+    */
+    Array<File> getSelectedFiles();
+
+    /*! shows and plays a file, the loaded file or one of the other targets. Doesn't own it
+        @param SegaudioFile* file
+        @return void
+    */
+    void showFile(SegaudioFile* file);
+
+    /*! fills the target selector, hidden when there's only one target
+        @param StringArray targetNames
+        @return void
+    */
+    void setTargetNames(StringArray targetNames);
+
+    /*! gets the index of the target picked in the target selector, sent with "targetSelected"
+        @return int
+    */
+    int getSelectedTargetIndex();
+
     /*! sets the state of UI so file can be played
         @param bool isPlayable
         @return void
@@ -101,12 +124,18 @@ public:
     */
     void setRegions(Array<AudioRegion>* regions_);
 
+    /*! lets the audioSourceSelector know the regions changed
+        @return void
+    */
+    void updateRegions();
+
     //[/UserMethods]
 
     void paint (Graphics& g);
     void resized();
     void buttonClicked (Button* buttonThatWasClicked);
     void sliderValueChanged (Slider* sliderThatWasMoved);
+    void comboBoxChanged (ComboBox* comboBoxThatHasChanged);
 
 
 
@@ -115,6 +144,10 @@ private:
     bool isPlayable;
 
     ScopedPointer<SegaudioFile> currentFile;  // loaded file
+    SegaudioFile* shownFile; // currentFile or another target from the model
+    Array<File> selectedFiles; // picked with the load button
+    ScopedPointer<ProgressBar> loadProgressBar; // shown while shownFile is decoding, after currentFile so it's deleted first
+    ScopedPointer<ComboBox> targetSelector; // picks the shown target when several were loaded
 
     AudioTransportSource audioTransport; // handles audio transport
     AudioSourcePlayer audioSourcePlayer; // handles audio playback
@@ -0,0 +1,165 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#include "WavRegionCopier.h"
+
+WavRegionCopier::WavRegionCopier(const File &sourceFile) : source(sourceFile){
+    dataStart = 0;
+    numFrames = 0;
+    bytesPerFrame = 0;
+    bitsPerSample = 0;
+    isCopyable = parseChunks();
+}
+
+WavRegionCopier::~WavRegionCopier(){
+}
+
+bool WavRegionCopier::canCopy(){
+    return isCopyable;
+}
+
+int WavRegionCopier::getBitsPerSample(){
+    return bitsPerSample;
+}
+
+bool WavRegionCopier::parseChunks(){
+
+    FileInputStream input(source);
+    if(input.failedToOpen()){
+        return false;
+    }
+
+    // RF64 is left to the re-encoding path, its sizes live in a ds64 chunk
+    char riffHeader[12];
+    if(input.read(riffHeader, 12) != 12 or memcmp(riffHeader, "RIFF", 4) != 0 or memcmp(riffHeader + 8, "WAVE", 4) != 0){
+        return false;
+    }
+
+    int64 fileSize = input.getTotalLength();
+
+    while(not input.isExhausted()){
+        char chunkId[4];
+        if(input.read(chunkId, 4) != 4){
+            break;
+        }
+        int64 chunkSize = uint32(input.readInt()); // little endian
+        int64 chunkStart = input.getPosition();
+
+        if(memcmp(chunkId, "fmt ", 4) == 0){
+            if(chunkSize < 16){
+                return false;
+            }
+            formatChunk.setSize(size_t(chunkSize));
+            input.read(formatChunk.getData(), int(chunkSize));
+
+            const uint8* format = static_cast<const uint8*>(formatChunk.getData());
+            int formatTag = ByteOrder::littleEndianShort(format);
+            bytesPerFrame = ByteOrder::littleEndianShort(format + 12);
+            bitsPerSample = ByteOrder::littleEndianShort(format + 14);
+
+            bool isPcm = (formatTag == 1 or formatTag == 3 or formatTag == 0xfffe); // int, float, extensible
+            if(not isPcm or bytesPerFrame <= 0){
+                return false;
+            }
+        }
+        else if(memcmp(chunkId, "data", 4) == 0){
+            if(formatChunk.getSize() == 0){ // fmt has to come first
+                return false;
+            }
+            dataStart = chunkStart;
+            numFrames = jmin(chunkSize, fileSize - chunkStart) / bytesPerFrame; // size can be wrong in unfinished files
+            return true;
+        }
+
+        if(not input.setPosition(chunkStart + chunkSize + (chunkSize & 1))){ // chunks are padded to even sizes
+            break;
+        }
+    }
+
+    return false;
+}
+
+bool WavRegionCopier::writeRanges(const File &destinationFile, const Array<Range<int64> > &sampleRanges, Listener* listener){
+
+    if(not isCopyable){
+        return false;
+    }
+
+    int64 numDataBytes = 0;
+    for(int i=0; i<sampleRanges.size(); i++){
+        Range<int64> range = sampleRanges[i].getIntersectionWith(Range<int64>(0, numFrames));
+        numDataBytes += range.getLength() * bytesPerFrame;
+    }
+
+    int64 formatChunkSize = int64(formatChunk.getSize());
+    int64 riffSize = 4 + (8 + formatChunkSize + (formatChunkSize & 1)) + (8 + numDataBytes + (numDataBytes & 1));
+    if(riffSize > 0xffffffffLL){
+        return false;
+    }
+
+    FileInputStream input(source);
+    FileOutputStream output(destinationFile);
+    if(input.failedToOpen() or output.failedToOpen()){
+        return false;
+    }
+    output.setPosition(0);
+    output.truncate(); // the file chooser already asked about replacing it
+
+    // headers are the only thing written new
+    output.write("RIFF", 4);
+    output.writeInt(int(uint32(riffSize)));
+    output.write("WAVE", 4);
+    output.write("fmt ", 4);
+    output.writeInt(int(formatChunkSize));
+    output.write(formatChunk.getData(), formatChunk.getSize());
+    if(formatChunkSize & 1){
+        output.writeByte(0);
+    }
+    output.write("data", 4);
+    output.writeInt(int(uint32(numDataBytes)));
+
+    for(int i=0; i<sampleRanges.size(); i++){
+        Range<int64> range = sampleRanges[i].getIntersectionWith(Range<int64>(0, numFrames));
+        if(range.isEmpty()){
+            continue;
+        }
+
+        if(not input.setPosition(dataStart + range.getStart() * bytesPerFrame)){
+            return false;
+        }
+
+        // in chunks, so multi GB regions report progress and can be cancelled
+        const int64 framesPerChunk = (1 << 20) / bytesPerFrame;
+        for(int64 frame=range.getStart(); frame<range.getEnd(); frame+=framesPerChunk){
+            int64 numChunkFrames = jmin(framesPerChunk, range.getEnd() - frame);
+            int64 numBytes = numChunkFrames * bytesPerFrame;
+            if(output.writeFromInputStream(input, numBytes) != numBytes){
+                return false;
+            }
+            if(listener != nullptr and not listener->framesCopied(numChunkFrames)){
+                return false;
+            }
+        }
+    }
+
+    if(numDataBytes & 1){
+        output.writeByte(0);
+    }
+
+    output.flush();
+    return not output.getStatus().failed();
+}
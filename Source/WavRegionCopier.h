@@ -0,0 +1,90 @@
+/*
+This file is part of Segaudio.
+
+Segaudio is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Segaudio is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
+/**/
+
+#ifndef WAVREGIONCOPIER_H_INCLUDED
+#define WAVREGIONCOPIER_H_INCLUDED
+
+#include "JuceHeader.h"
+
+/*! exports regions of a PCM or float WAV file by copying their bytes into new WAV files, without decoding
+
+    The source's fmt chunk is copied as it is, so the new files keep the bit depth and channel layout, and only the
+    RIFF and data chunk sizes are written new. Copying is bound by disk speed instead of encoding.
+*/
+class WavRegionCopier
+{
+
+public:
+    /*! reads the chunk layout of the source
+        @param const File &sourceFile
+    */
+    WavRegionCopier(const File &sourceFile);
+    ~WavRegionCopier();
+
+    /*! check if the source is a RIFF WAV file with integer PCM or float samples
+        @return bool
+    */
+    bool canCopy();
+
+    /*! gets the bits per sample of the source
+        @return int
+    */
+    int getBitsPerSample();
+
+    /*! follows a copy chunk by chunk, for progress and cancelling
+    */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        /*! called on the copying thread after each chunk
+            @param int64 numFrames: frames copied since the last call
+            @return bool: false stops the copy
+        */
+        virtual bool framesCopied(int64 numFrames) = 0;
+    };
+
+    /*! writes the sample ranges one after another into one WAV file
+        @param const File &destinationFile: replaced if it exists
+        @param const Array<Range<int64> > &sampleRanges: start and end sample of each region
+        @param Listener* listener: told about every chunk, nullptr if not needed
+        @return bool: false if the source can't be copied, the result would pass the 4GB WAV limit or the listener
+        stopped the copy
+    */
+    bool writeRanges(const File &destinationFile, const Array<Range<int64> > &sampleRanges, Listener* listener);
+
+private:
+    File source;
+    bool isCopyable;
+
+    MemoryBlock formatChunk; // fmt chunk contents, written as they are
+    int64 dataStart; // byte position of the first sample
+    int64 numFrames; // samples per channel in the data chunk
+    int bytesPerFrame;
+    int bitsPerSample;
+
+    /*! finds the fmt and data chunks
+        @return bool: false if not a WAV file this can copy from
+    */
+    bool parseChunks();
+
+    JUCE_DECLARE_NON_COPYABLE (WavRegionCopier)
+};
+
+
+#endif  // WAVREGIONCOPIER_H_INCLUDED
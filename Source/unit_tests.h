@@ -21,6 +21,21 @@ along with Segaudio.  If not, see <http://www.gnu.org/licenses/>.
 #include "JuceHeader.h"
 
 #include "AudioRegion.h"
+#include "AudioRegionIndex.h"
+#include "DistanceStatistics.h"
+#include "OnlineRegionSegmenter.h"
+#include "SegaudioFile.h"
+#include "CompactSampleBuffer.h"
+#include "SampleBlockCache.h"
+#include "FileFingerprint.h"
+#include "WavRegionCopier.h"
+#include "RegionExporter.h"
+#include "RegionRenderer.h"
+#include "BatchExportPlan.h"
+#include "ExportQueue.h"
+#include "RegionBoundaryWriter.h"
+#include "AnalysisEngine.h"
+#include "BatchSearch.h"
 #include "AudioAnalysisController.h"
 #include "SegaudioModel.h"
 
@@ -48,12 +63,664 @@ public:
         expect(r1.getStart() == 0, "AudioRegion start out of bounds fail");
         expect(r1.getEnd() - 0.01 < 0.0001, "AudioRegion end before start fail");
 
+        beginTest ("Part 3: AudioRegion Sample Accuracy");
+        int64 longFileSamples = int64(48000) * 60 * 60 * 10; // 10 hours, float fractions can't hold single samples
+        AudioRegion r2 = AudioRegion(longFileSamples - 48001, longFileSamples - 1, longFileSamples, 48000.0);
+        expect(r2.isSampleAccurate(), "AudioRegion sample accurate fail");
+        expect(r2.getStartSample(longFileSamples) == longFileSamples - 48001, "AudioRegion getStartSample fail");
+        expect(r2.getEndSample(longFileSamples) == longFileSamples - 1, "AudioRegion getEndSample fail");
+        expect(r2.getSampleRate() == 48000.0, "AudioRegion getSampleRate fail");
+        expect(!testRegion.isSampleAccurate(), "AudioRegion fractional region fail");
+        expect(testRegion.getStartSample(400) == 100, "AudioRegion fractional getStartSample fail");
+
     }
 
     AudioRegion testRegion;
 };
 
 
+class AudioRegionIndexTest : public UnitTest
+{
+public:
+    AudioRegionIndexTest()  : UnitTest ("Segaudio Testing") {
+
+        regions.add(AudioRegion(0.6, 0.7));
+        regions.add(AudioRegion(0.1, 0.2));
+        regions.add(AudioRegion(0.15, 0.5)); // overlaps the one before
+        regions.add(AudioRegion(0.8, 0.9));
+
+    }
+    void runTest()
+    {
+        beginTest ("Part 1: AudioRegionIndex Queries");
+        AudioRegionIndex index;
+        index.build(&regions);
+        Array<int> results;
+
+        index.findContaining(0.17, &results);
+        expect(results.size() == 2 && results[0] == 1 && results[1] == 2, "AudioRegionIndex findContaining failed");
+
+        index.findContaining(0.75, &results);
+        expect(results.size() == 0, "AudioRegionIndex findContaining outside regions failed");
+
+        index.findInRange(0.45, 0.85, &results);
+        expect(results.size() == 3 && results[0] == 2 && results[1] == 0 && results[2] == 3, "AudioRegionIndex findInRange failed");
+
+        index.findOverlapping(AudioRegion(0.55, 0.65), &results);
+        expect(results.size() == 1 && results[0] == 0, "AudioRegionIndex findOverlapping failed");
+
+        index.findOverlapping(AudioRegion(0.7, 0.8), &results);
+        expect(results.size() == 0, "AudioRegionIndex touching regions should not overlap");
+
+        beginTest ("Part 2: AudioRegionIndex Boundaries");
+        bool isStart = false;
+        expect(index.findBoundaryNear(0.601, 0.005, &isStart) == 0 && isStart, "AudioRegionIndex start boundary failed");
+        expect(index.findBoundaryNear(0.898, 0.005, &isStart) == 3 && !isStart, "AudioRegionIndex end boundary failed");
+        expect(index.findBoundaryNear(0.75, 0.005, &isStart) == -1, "AudioRegionIndex no boundary failed");
+    }
+
+    Array<AudioRegion> regions;
+};
+
+
+class DistanceStatisticsTest : public UnitTest
+{
+public:
+    DistanceStatisticsTest()  : UnitTest ("Segaudio Testing") {
+
+        float distances[] = {0.5f, 0.2f, 0.9f, 0.1f, 0.4f, 0.7f};
+        distanceArray.addArray(distances, 6);
+
+    }
+    void runTest()
+    {
+        beginTest ("Part 1: DistanceStatistics Ranges");
+        DistanceStatistics stats;
+        stats.build(&distanceArray);
+
+        expect(stats.getNumBlocks() == 6, "DistanceStatistics numBlocks failed");
+        expect(fabs(stats.getAreaDistance(0, 6) - 2.8) < 0.0001, "DistanceStatistics full area failed");
+        expect(fabs(stats.getAreaDistance(1, 4) - 1.2) < 0.0001, "DistanceStatistics area failed");
+        expect(fabs(stats.getMeanDistance(1, 4) - 0.4) < 0.0001, "DistanceStatistics mean failed");
+        expect(stats.getMinDistance(0, 3) == 0.2f, "DistanceStatistics min failed");
+        expect(stats.getMinDistance(4, 6) == 0.4f, "DistanceStatistics min at end failed");
+        expect(stats.getMinDistance(2, 3) == 0.9f, "DistanceStatistics single block min failed");
+        expect(stats.getMeanDistance(3, 3) == 0.0f, "DistanceStatistics empty range failed");
+
+        beginTest ("Part 2: DistanceStatistics Silent Blocks");
+        Array<float> silentDistances(distanceArray);
+        silentDistances.set(1, std::numeric_limits<float>::quiet_NaN()); // 0/0 of a silent block
+        silentDistances.set(3, -std::numeric_limits<float>::infinity()); // log(0) of a silent block
+        stats.build(&silentDistances);
+
+        expect(fabs(stats.getAreaDistance(0, 6) - (0.5 + 0.9 + 0.9 + 0.9 + 0.4 + 0.7)) < 0.0001, "DistanceStatistics silent area failed");
+        expect(fabs(stats.getMeanDistance(4, 6) - 0.55) < 0.0001, "DistanceStatistics range after silence failed");
+        expect(stats.getMinDistance(0, 6) == 0.4f, "DistanceStatistics silent min failed");
+    }
+
+    Array<float> distanceArray;
+};
+
+
+class OnlineRegionSegmenterTest : public UnitTest
+{
+public:
+    OnlineRegionSegmenterTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: OnlineRegionSegmenter Incremental Regions");
+
+        float distances[] = {1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f};
+
+        ClusterParameters clusterParams;
+        clusterParams.threshold = 0.5;
+        clusterParams.regionConnectionWidth = 0; // connects blocks 1 apart
+
+        OnlineRegionSegmenter segmenter;
+        segmenter.reset(clusterParams, 10, 2);
+
+        Array<Range<int> > regions;
+        for(int i=0; i<8; i++){
+            segmenter.addDistance(distances[i]);
+        }
+        expect(segmenter.takeFinishedRegions(&regions) == 0, "OnlineRegionSegmenter emitted before look-ahead failed");
+
+        segmenter.addDistance(distances[8]);
+        expect(segmenter.takeFinishedRegions(&regions) == 1, "OnlineRegionSegmenter incremental region failed");
+        expect(regions[0].getStart() == 2 and regions[0].getEnd() == 4, "OnlineRegionSegmenter region blocks failed");
+
+        segmenter.addDistance(distances[9]);
+        segmenter.finish();
+        expect(segmenter.takeFinishedRegions(&regions) == 1, "OnlineRegionSegmenter finish failed");
+        expect(regions[1].getStart() == 8 and regions[1].getEnd() == 9, "OnlineRegionSegmenter last region failed");
+
+        beginTest ("Part 2: OnlineRegionSegmenter Width Filter");
+        clusterParams.maxRegionTimeWidth = 0.15f;
+        segmenter.reset(clusterParams, 10, 2);
+        regions.clear();
+        for(int i=0; i<10; i++){
+            segmenter.addDistance(distances[i]);
+        }
+        segmenter.finish();
+        segmenter.takeFinishedRegions(&regions);
+        expect(regions.size() == 1 and regions[0].getStart() == 8, "OnlineRegionSegmenter width filter failed");
+    }
+};
+
+
+class SegaudioFileTest : public UnitTest
+{
+public:
+    SegaudioFileTest()  : UnitTest ("Segaudio Testing") {}
+
+    // adds up the blocks it's passed, like the thumbnail does
+    class LoadedSampleCounter : public SegaudioFile::Listener
+    {
+    public:
+        LoadedSampleCounter() : numSamples(0), lastSample(0) {}
+        void samplesLoaded(SegaudioFile* file, const AudioSampleBuffer &block, int64 startSample){
+            numSamples += block.getNumSamples();
+            lastSample = block.getSample(0, block.getNumSamples() - 1);
+        }
+        int64 numSamples;
+        float lastSample;
+    };
+
+    void runTest()
+    {
+        beginTest ("Part 1: SegaudioFile Memory Mapped Windows");
+
+        // write a short ramp so every sample is known
+        File tempFile = File::createTempFile(".wav");
+        AudioSampleBuffer ramp(1, 1000);
+        for(int i=0; i<1000; i++){
+            ramp.setSample(0, i, i / 1000.0f);
+        }
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(tempFile.createOutputStream(), 44100, 1, 32, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(ramp, 0, 1000);
+        writer = nullptr; // flushes and closes file
+
+        SegaudioFile segaudioFile;
+        segaudioFile.setFile(tempFile);
+
+        expect(segaudioFile.isMemoryMapped(), "SegaudioFile mapping wav failed");
+        expect(segaudioFile.getNumSamples() == 1000, "SegaudioFile num samples failed");
+
+        AudioSampleBuffer window(1, 100);
+        segaudioFile.readSamples(&window, 0, 500, 100);
+        expect(fabs(window.getSample(0, 0) - 0.5f) < 0.0001, "SegaudioFile window start failed");
+        expect(fabs(window.getSample(0, 99) - 0.599f) < 0.0001, "SegaudioFile window end failed");
+
+        segaudioFile.readSamples(&window, 0, 950, 100);
+        expect(window.getSample(0, 60) == 0.0f, "SegaudioFile past end failed");
+
+        beginTest ("Part 2: SegaudioFile Content Hash Survives Renames");
+        File movedFile = File::createTempFile(".wav");
+        tempFile.copyFileTo(movedFile);
+
+        SegaudioFile movedSegaudioFile;
+        movedSegaudioFile.setFile(movedFile);
+        expect(segaudioFile.getContentHash() != 0, "SegaudioFile content hash not set");
+        expect(segaudioFile.getContentHash() == movedSegaudioFile.getContentHash(), "SegaudioFile content hash depends on name");
+
+        movedSegaudioFile.setFile(tempFile); // unmaps movedFile so it can be deleted
+        movedFile.deleteFile();
+
+        beginTest ("Part 3: SegaudioFile Listener Added After Loading");
+        File flacFile = File::createTempFile(".flac");
+        FlacAudioFormat flacFormat;
+        writer = flacFormat.createWriterFor(flacFile.createOutputStream(), 44100, 1, 16, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(ramp, 0, 1000);
+        writer = nullptr;
+
+        SegaudioFile decodedFile;
+        decodedFile.setFile(flacFile);
+        expect(not decodedFile.isMemoryMapped() and decodedFile.loadOnCallingThread() and decodedFile.isFullyLoaded(), "SegaudioFile loading on calling thread failed");
+
+        LoadedSampleCounter counter;
+        decodedFile.addListenerWithLoadedSamples(&counter);
+        expect(counter.numSamples == 1000 and fabs(counter.lastSample - 0.999f) < 0.001, "SegaudioFile loaded samples not passed to new listener");
+        decodedFile.removeListener(&counter);
+
+        flacFile.deleteFile();
+        tempFile.deleteFile();
+    }
+};
+
+
+class FileFingerprintTest : public UnitTest
+{
+public:
+    FileFingerprintTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: FileFingerprint XXH64 Reference Values");
+
+        const char* longInput = "Nobody inspects the spammish repetition"; // over 32 bytes, uses the four lanes
+        expect(FileFingerprint::xxHash64("", 0, 0) == 0xef46db3751d8e999ULL, "FileFingerprint empty hash failed");
+        expect(FileFingerprint::xxHash64("abc", 3, 0) == 0x44bc2cf5ad770999ULL, "FileFingerprint short hash failed");
+        expect(FileFingerprint::xxHash64(longInput, strlen(longInput), 0) == 0xfbcea83c8a378bf1ULL, "FileFingerprint long hash failed");
+    }
+};
+
+
+class WavRegionCopierTest : public UnitTest
+{
+public:
+    WavRegionCopierTest()  : UnitTest ("Segaudio Testing") {}
+
+    // counts copied frames, stopping after the first chunk if asked
+    class CopyCounter : public WavRegionCopier::Listener
+    {
+    public:
+        CopyCounter(bool stopAfterFirstChunk){
+            shouldStop = stopAfterFirstChunk;
+            numFramesCopied = 0;
+        };
+
+        bool framesCopied(int64 numFrames){
+            numFramesCopied += numFrames;
+            return not shouldStop;
+        }
+
+        bool shouldStop;
+        int64 numFramesCopied;
+    };
+
+    void runTest()
+    {
+        beginTest ("Part 1: WavRegionCopier Keeps Samples And Bit Depth");
+
+        File sourceFile = File::createTempFile(".wav");
+        AudioSampleBuffer ramp(2, 1000);
+        for(int i=0; i<1000; i++){
+            ramp.setSample(0, i, i / 1000.0f);
+            ramp.setSample(1, i, -i / 1000.0f);
+        }
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(sourceFile.createOutputStream(), 44100, 2, 24, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(ramp, 0, 1000);
+        writer = nullptr; // flushes and closes file
+
+        WavRegionCopier copier(sourceFile);
+        expect(copier.canCopy() and copier.getBitsPerSample() == 24, "WavRegionCopier parsing failed");
+
+        Array<Range<int64> > sampleRanges;
+        sampleRanges.add(Range<int64>(100, 200));
+        sampleRanges.add(Range<int64>(500, 550));
+
+        File copiedFile = File::createTempFile(".wav");
+        CopyCounter counter(false);
+        expect(copier.writeRanges(copiedFile, sampleRanges, &counter), "WavRegionCopier writing failed");
+        expect(counter.numFramesCopied == 150, "WavRegionCopier progress failed");
+
+        ScopedPointer<AudioFormatReader> reader = wavFormat.createReaderFor(copiedFile.createInputStream(), true);
+        expect(reader != nullptr and reader->lengthInSamples == 150 and reader->bitsPerSample == 24, "WavRegionCopier header failed");
+
+        if(reader != nullptr){
+            AudioSampleBuffer copied(2, 150);
+            reader->read(&copied, 0, 150, 0, true, true);
+            expect(fabs(copied.getSample(0, 0) - 0.1f) < 0.0001 and fabs(copied.getSample(1, 100) + 0.5f) < 0.0001, "WavRegionCopier samples failed");
+        }
+
+        reader = nullptr;
+
+        CopyCounter cancellingCounter(true);
+        expect(not copier.writeRanges(copiedFile, sampleRanges, &cancellingCounter) and cancellingCounter.numFramesCopied == 100, "WavRegionCopier cancel failed");
+
+        copiedFile.deleteFile();
+        sourceFile.deleteFile();
+    }
+};
+
+
+class RegionExporterTest : public UnitTest
+{
+public:
+    RegionExporterTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: RegionExporter Deterministic File Names");
+
+        File destinationFile = File::getSpecialLocation(File::tempDirectory).getChildFile("claps");
+        File firstFile = RegionExporter::getRegionFile(destinationFile, 0, 2000, 44100, 66150, 44100, "wav");
+        File secondFile = RegionExporter::getRegionFile(destinationFile, 1, 2000, 44150, 66200, 44100, "wav");
+
+        expect(firstFile.getFileName() == "claps_0000_1-1.wav", "RegionExporter file name failed");
+        expect(firstFile != secondFile, "RegionExporter regions in the same seconds share a file");
+        expect(RegionExporter::getRegionFile(destinationFile, 0, 2000, 44100, 66150, 44100, "wav") == firstFile, "RegionExporter file name not deterministic");
+        expect(RegionExporter::getRegionFile(destinationFile, 0, 2000, 44100, 66150, 44100, "flac").hasFileExtension("flac"), "RegionExporter flac extension failed");
+
+        // names from the save dialog have an extension, and the name before it can have dots too
+        File namedFile = File::getSpecialLocation(File::tempDirectory).getChildFile("claps.take.01.wav");
+        File firstNamedFile = RegionExporter::getRegionFile(namedFile, 0, 2000, 44100, 66150, 44100, "wav");
+        File secondNamedFile = RegionExporter::getRegionFile(namedFile, 1, 2000, 44150, 66200, 44100, "wav");
+        expect(firstNamedFile.getFileName() == "claps.take.01_0000_1-1.wav", "RegionExporter file name with extension failed");
+        expect(firstNamedFile != secondNamedFile and firstNamedFile.getParentDirectory() == namedFile.getParentDirectory(), "RegionExporter regions with an extension share a file");
+    }
+};
+
+
+class RegionRendererTest : public UnitTest
+{
+public:
+    RegionRendererTest()  : UnitTest ("Segaudio Testing") {}
+
+    // renders two regions of 10 samples, ones then zeros, and reads the result back. A region of halves goes
+    // between them if numMiddleSamples isn't 0
+    AudioSampleBuffer renderRegions(int gapSamples, int crossfadeSamples, int numMiddleSamples = 0)
+    {
+        Array<int> regionLengths;
+        Array<float> regionValues;
+        regionLengths.add(10); regionValues.add(1.0f);
+        if(numMiddleSamples > 0){
+            regionLengths.add(numMiddleSamples); regionValues.add(0.5f);
+        }
+        regionLengths.add(10); regionValues.add(0.0f);
+
+        File renderedFile = File::createTempFile(".wav");
+        WavAudioFormat wavFormat;
+        AudioFormatWriter* writer = wavFormat.createWriterFor(renderedFile.createOutputStream(), 44100, 1, 32, StringPairArray(), 0);
+        {
+            RegionRenderer renderer(writer, 1, nullptr);
+            renderer.setJoin(gapSamples, crossfadeSamples);
+            for(int i=0; i<regionLengths.size(); i++){
+                renderer.startRegion(regionLengths[i]);
+                for(int numRendered=0; numRendered<regionLengths[i]; ){
+                    int numSamples = renderer.prepareSpace(regionLengths[i] - numRendered);
+                    for(int j=0; j<numSamples; j++){
+                        renderer.getBlock()->setSample(0, renderer.getWritePosition() + j, regionValues[i]);
+                    }
+                    renderer.commit(numSamples);
+                    numRendered += numSamples;
+                }
+            }
+        } // writes and closes the file
+
+        ScopedPointer<AudioFormatReader> reader = wavFormat.createReaderFor(renderedFile.createInputStream(), true);
+        AudioSampleBuffer rendered(1, int(reader->lengthInSamples));
+        reader->read(&rendered, 0, rendered.getNumSamples(), 0, true, true);
+        reader = nullptr;
+        renderedFile.deleteFile();
+        return rendered;
+    }
+
+    void runTest()
+    {
+        beginTest ("Part 1: RegionRenderer Gap");
+
+        AudioSampleBuffer rendered = renderRegions(3, 0);
+        expect(rendered.getNumSamples() == 23, "RegionRenderer gap length failed");
+        expect(rendered.getSample(0, 9) == 1.0f and rendered.getSample(0, 10) == 0.0f and rendered.getSample(0, 13) == 0.0f, "RegionRenderer gap samples failed");
+
+        beginTest ("Part 2: RegionRenderer Crossfade");
+
+        rendered = renderRegions(0, 4);
+        expect(rendered.getNumSamples() == 16, "RegionRenderer crossfade length failed");
+        expect(rendered.getSample(0, 5) == 1.0f and rendered.getSample(0, 7) == 0.75f and rendered.getSample(0, 9) == 0.25f and rendered.getSample(0, 10) == 0.0f, "RegionRenderer crossfade samples failed");
+
+        beginTest ("Part 3: RegionRenderer Crossfade Over A Short Region");
+
+        // both fades are only 2 samples, the last one mustn't reach into the ones
+        rendered = renderRegions(0, 4, 2);
+        expect(rendered.getNumSamples() == 18, "RegionRenderer short region crossfade length failed");
+        expect(rendered.getSample(0, 7) == 1.0f and rendered.getSample(0, 8) == 1.0f and rendered.getSample(0, 9) == 0.375f and rendered.getSample(0, 10) == 0.0f, "RegionRenderer short region crossfade samples failed");
+    }
+};
+
+
+class BatchExportPlanTest : public UnitTest
+{
+public:
+    BatchExportPlanTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: BatchExportPlan Reading Order And Names");
+
+        File tempDirectory = File::getSpecialLocation(File::tempDirectory);
+        File destinationDirectory = tempDirectory.getChildFile("batch");
+
+        Array<AudioRegion> regions;
+        regions.add(AudioRegion(0, 100, 1000, 44100));
+
+        BatchExportPlan plan;
+        plan.addFileToDirectory(tempDirectory.getChildFile("b").getChildFile("take.wav"), regions, destinationDirectory, "wav");
+        plan.addFileToDirectory(tempDirectory.getChildFile("a").getChildFile("take.wav"), regions, destinationDirectory, "wav");
+        plan.addFileToDirectory(tempDirectory.getChildFile("a").getChildFile("intro.wav"), regions, destinationDirectory, "wav");
+
+        expect(plan.getNumFiles() == 3 and plan.getNumRegions() == 3, "BatchExportPlan counts failed");
+        expect(plan.getSourceFile(0).getFileName() == "intro.wav" and plan.getSourceFile(1).getParentDirectory().getFileName() == "a", "BatchExportPlan path order failed");
+        expect(plan.getDestinationFile(2) == destinationDirectory.getChildFile("take.wav") and plan.getDestinationFile(1) == destinationDirectory.getChildFile("take_2.wav"), "BatchExportPlan names failed");
+
+        beginTest ("Part 2: BatchExportPlan Names With Dots");
+
+        BatchExportPlan dottedPlan;
+        dottedPlan.addFileToDirectory(tempDirectory.getChildFile("take.01.wav"), regions, destinationDirectory, "flac");
+        dottedPlan.addFileToDirectory(tempDirectory.getChildFile("take.02.wav"), regions, destinationDirectory, "flac");
+        expect(dottedPlan.getDestinationFile(0).getFileName() == "take.01.flac" and dottedPlan.getDestinationFile(1).getFileName() == "take.02.flac", "BatchExportPlan dotted names failed");
+
+        // the export replaces the extension, so the two files must still be written apart
+        File firstRegionFile = RegionExporter::getRegionFile(dottedPlan.getDestinationFile(0), 0, 1, 0, 100, 44100, "flac");
+        File secondRegionFile = RegionExporter::getRegionFile(dottedPlan.getDestinationFile(1), 0, 1, 0, 100, 44100, "flac");
+        expect(firstRegionFile != secondRegionFile and dottedPlan.getDestinationFile(0).withFileExtension("flac") != dottedPlan.getDestinationFile(1).withFileExtension("flac"), "BatchExportPlan dotted names clash after export");
+    }
+};
+
+
+class ExportQueueTest : public UnitTest
+{
+public:
+    ExportQueueTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: ExportQueue Background Export And Summary");
+
+        File sourceFile = File::createTempFile(".wav");
+        AudioSampleBuffer ramp(1, 44100);
+        for(int i=0; i<44100; i++){
+            ramp.setSample(0, i, i / 44100.0f);
+        }
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(sourceFile.createOutputStream(), 44100, 1, 16, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(ramp, 0, 44100);
+        writer = nullptr; // flushes and closes file
+
+        Array<AudioRegion> regions;
+        regions.add(AudioRegion(0, 11025, 44100, 44100));
+        regions.add(AudioRegion(22050, 33075, 44100, 44100));
+
+        File destinationFile = File::getSpecialLocation(File::tempDirectory).getChildFile("queued_export");
+        ExportQueue exportQueue;
+        exportQueue.addExport(sourceFile, regions, destinationFile, true, "wav", 0, 0);
+
+        for(int i=0; i<100 and exportQueue.getNumExports() > 0; i++){ // the queue runs on its own thread
+            Thread::sleep(50);
+        }
+
+        ExportSummary summary = exportQueue.getLastSummary();
+        File exportedFile = destinationFile.withFileExtension("wav");
+        expect(exportQueue.getNumExports() == 0 and not summary.wasCancelled, "ExportQueue export didn't finish");
+        expect(summary.numWritten == 2 and summary.numRegions == 2, "ExportQueue summary regions failed");
+        expect(summary.numBytes == exportedFile.getSize() and summary.numBytes > 22050 * 2, "ExportQueue summary bytes failed");
+
+        exportedFile.deleteFile();
+        sourceFile.deleteFile();
+    }
+};
+
+
+class RegionBoundaryWriterTest : public UnitTest
+{
+public:
+    RegionBoundaryWriterTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: RegionBoundaryWriter CSV Sample Positions");
+
+        int64 totalNumSamples = int64(44100) * 60 * 60 * 10; // ten hours, past float precision
+        Array<AudioRegion> regions;
+        regions.add(AudioRegion(totalNumSamples - 44100, totalNumSamples, totalNumSamples, 44100));
+        AudioRegion scoredRegion(0, 44100, totalNumSamples, 44100);
+        scoredRegion.setScore(0.5f, 0.25f, 2.0f);
+        regions.add(scoredRegion);
+        AudioRegion nanRegion(44100, 88200, totalNumSamples, 44100);
+        nanRegion.setScore(std::numeric_limits<float>::quiet_NaN(), 0.25f, std::numeric_limits<float>::infinity());
+        regions.add(nanRegion);
+
+        File csvFile = File::getSpecialLocation(File::tempDirectory).getChildFile("boundaries.csv");
+        expect(RegionBoundaryWriter::writeRegions(&regions, csvFile, RegionBoundaryWriter::csv, totalNumSamples, 44100), "RegionBoundaryWriter CSV write failed");
+
+        StringArray lines;
+        lines.addLines(csvFile.loadFileAsString());
+        expect(lines[0].startsWith("35999.000000, 36000.000000, " + String(totalNumSamples - 44100) + ", " + String(totalNumSamples) + ", , , "), "RegionBoundaryWriter CSV unscored line failed");
+        expect(lines[1].startsWith("0.000000, 1.000000, 0, 44100, 0.5, 0.25, "), "RegionBoundaryWriter CSV scored line failed");
+        expect(lines[2] == "1.000000, 2.000000, 44100, 88200, , 0.25, ", "RegionBoundaryWriter CSV nan score failed");
+
+        beginTest ("Part 2: RegionBoundaryWriter JSON Lines");
+
+        File jsonFile = csvFile.withFileExtension(".jsonl");
+        expect(RegionBoundaryWriter::getFormatForFile(jsonFile) == RegionBoundaryWriter::jsonLines, "RegionBoundaryWriter format from extension failed");
+        expect(RegionBoundaryWriter::writeRegions(&regions, jsonFile, RegionBoundaryWriter::jsonLines, totalNumSamples, 44100), "RegionBoundaryWriter JSON write failed");
+
+        lines.clear();
+        lines.addLines(jsonFile.loadFileAsString());
+        var secondRegion = JSON::parse(lines[1]);
+        expect(int64(secondRegion["endSample"]) == 44100 and float(secondRegion["minDistance"]) == 0.25f, "RegionBoundaryWriter JSON values failed");
+        expect(JSON::parse(lines[0])["meanDistance"].isVoid(), "RegionBoundaryWriter JSON unscored region failed");
+        var nanScores;
+        expect(JSON::parse(lines[2], nanScores).wasOk() and nanScores["meanDistance"].isVoid() and nanScores["areaDistance"].isVoid()
+               and float(nanScores["minDistance"]) == 0.25f, "RegionBoundaryWriter JSON nan score not null");
+
+        beginTest ("Part 3: RegionBoundaryWriter Binary Records");
+
+        File binaryFile = csvFile.withFileExtension(".bin");
+        expect(RegionBoundaryWriter::writeRegions(&regions, binaryFile, RegionBoundaryWriter::binary, totalNumSamples, 44100), "RegionBoundaryWriter binary write failed");
+        expect(binaryFile.getSize() == RegionBoundaryWriter::binaryHeaderSize + 3 * RegionBoundaryWriter::binaryRecordSize, "RegionBoundaryWriter binary size failed");
+
+        FileInputStream input(binaryFile);
+        input.setPosition(RegionBoundaryWriter::binaryHeaderSize);
+        expect(input.readInt64() == totalNumSamples - 44100, "RegionBoundaryWriter binary start sample failed");
+        input.setPosition(RegionBoundaryWriter::binaryHeaderSize + RegionBoundaryWriter::binaryRecordSize + 28);
+        expect(input.readInt() == 1, "RegionBoundaryWriter binary score flag failed");
+
+        csvFile.deleteFile();
+        jsonFile.deleteFile();
+        binaryFile.deleteFile();
+    }
+};
+
+
+class CompactSampleBufferTest : public UnitTest
+{
+public:
+    CompactSampleBufferTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: CompactSampleBuffer int16 Round Trip");
+
+        AudioSampleBuffer source(2, 4);
+        float values[] = {0.0f, 0.5f, -0.25f, 12345.0f / 32768.0f};
+        for(int i=0; i<4; i++){
+            source.setSample(0, i, values[i]);
+            source.setSample(1, i, -values[i]);
+        }
+
+        CompactSampleBuffer compact(2, 4, true);
+        compact.writeFrom(source, 4);
+        expect(compact.getSizeInBytes() == 2 * 4 * sizeof(int16), "CompactSampleBuffer int16 size failed");
+
+        AudioSampleBuffer dest(2, 4);
+        compact.readInto(&dest, 0, 0, 0, 0, 4);
+        compact.readInto(&dest, 1, 0, 1, 0, 4);
+
+        bool isExact = true;
+        for(int i=0; i<4; i++){
+            isExact = isExact and dest.getSample(0, i) == values[i] and dest.getSample(1, i) == -values[i];
+        }
+        expect(isExact, "CompactSampleBuffer 16 bit values not exact");
+
+        beginTest ("Part 2: CompactSampleBuffer Clipping");
+        source.setSample(0, 0, 2.0f);
+        compact.writeFrom(source, 4);
+        compact.readInto(&dest, 0, 0, 0, 0, 1);
+        expect(dest.getSample(0, 0) == 32767.0f / 32768.0f, "CompactSampleBuffer clipping failed");
+    }
+};
+
+
+class SampleBlockCacheTest : public UnitTest
+{
+public:
+    SampleBlockCacheTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: SampleBlockCache LRU Eviction");
+
+        SampleBlockCache cache; // not the shared one, files may be using it
+        size_t blockBytes = CompactSampleBuffer(1, 100, true).getSizeInBytes();
+        cache.setMaxBytes(3 * blockBytes);
+
+        int fileId = cache.createFileId();
+        for(int i=0; i<3; i++){
+            cache.addBlock(fileId, i, new CachedSampleBlock(1, 100, true));
+        }
+        cache.getBlock(fileId, 0); // block 1 is now the least recently used
+        cache.addBlock(fileId, 3, new CachedSampleBlock(1, 100, true));
+
+        expect(cache.containsBlock(fileId, 0) and not cache.containsBlock(fileId, 1), "SampleBlockCache evicted wrong block");
+        expect(cache.getCurrentBytes() == 3 * blockBytes, "SampleBlockCache over budget");
+
+        beginTest ("Part 2: SampleBlockCache Remove File");
+        int otherFileId = cache.createFileId();
+        cache.setMaxBytes(10 * blockBytes);
+        cache.addBlock(otherFileId, 0, new CachedSampleBlock(1, 100, true));
+        cache.removeFile(fileId);
+        expect(cache.getCurrentBytes() == blockBytes and cache.containsBlock(otherFileId, 0), "SampleBlockCache removeFile failed");
+    }
+};
+
+
+class SegaudioModelTest : public UnitTest
+{
+public:
+    SegaudioModelTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: SegaudioModel Targets Keep Their Own Results");
+
+        SegaudioModel model(2);
+        SegaudioFile firstFile, secondFile;
+        model.addFile(&firstFile, "1");
+        model.addFile(&secondFile, "2");
+        expect(model.getTargetIds().size() == 2 and model.getActiveTargetId() == "1", "SegaudioModel targets failed");
+
+        model.getDistanceArray()->add(1.0f);
+        model.getTargetRegions()->add(AudioRegion(0.0f, 0.5f));
+        expect(model.setActiveTarget("2"), "SegaudioModel setActiveTarget failed");
+        expect(model.getDistanceArray()->size() == 0 and model.getTargetRegions()->size() == 0, "SegaudioModel target results shared");
+        expect(model.getSegaudioFile("2") == &secondFile, "SegaudioModel getSegaudioFile failed");
+
+        beginTest ("Part 2: SegaudioModel Remove Targets");
+        model.removeTargets();
+        expect(model.getTargetIds().size() == 1 and model.getActiveTargetId() == "1", "SegaudioModel removeTargets failed");
+        expect(model.getTargetRegions()->size() == 0 and not model.setActiveTarget("2"), "SegaudioModel removed target still there");
+    }
+};
+
+
 class AnalysisControllerTest : public UnitTest
 {
 public:
@@ -84,7 +751,7 @@ public:
 
         Array<AudioRegion> regions;
 
-        testController->getClusterRegions(&clusterParams, &distanceArray, &maxDistance, &regions);
+        testController->getClusterRegions(&clusterParams, &distanceArray, &maxDistance, &regions, nullptr, nullptr);
 
         expect(regions.size() == 3, "Number regions incorrect");
 
@@ -95,6 +762,191 @@ public:
 };
 
 
+class AnalysisEngineTest : public UnitTest
+{
+public:
+    AnalysisEngineTest()  : UnitTest ("Segaudio Testing") {}
+
+    // stops before the first target block, like pressing cancel
+    class CancelledEngine : public AnalysisEngine
+    {
+    protected:
+        bool isCalculationCancelled(){ return true; }
+    };
+
+    void runTest()
+    {
+        beginTest ("Part 1: AnalysisEngine Without GUI");
+
+        AnalysisEngine engine;
+
+        Array<float> distanceArray;
+        distanceArray.add(0.0);
+        distanceArray.add(1.0);
+        distanceArray.add(0.0);
+        distanceArray.add(1.0);
+        distanceArray.add(0.0);
+
+        ClusterParameters clusterParams;
+        clusterParams.threshold = 0.5;
+
+        float maxDistance = 1.0f;
+
+        Array<AudioRegion> regions;
+        engine.getClusterRegions(&clusterParams, &distanceArray, &maxDistance, &regions, nullptr, nullptr);
+        expect(regions.size() == 3, "AnalysisEngine number regions incorrect");
+
+        beginTest ("Part 2: AnalysisEngine Similarity Function");
+
+        // 12 blocks of noise getting louder, one distance per block
+        int blockSize = 2048*4;
+        File tempFile = File::createTempFile(".wav");
+        AudioSampleBuffer noise(1, blockSize*12);
+        Random random(49);
+        for(int i=0; i<noise.getNumSamples(); i++){
+            noise.setSample(0, i, (random.nextFloat() * 2.0f - 1.0f) * (1 + i / blockSize) / 12.0f);
+        }
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(tempFile.createOutputStream(), 44100, 1, 32, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(noise, 0, noise.getNumSamples());
+        writer = nullptr; // flushes and closes file
+
+        ScopedPointer<SegaudioFile> segaudioFile = new SegaudioFile();
+        segaudioFile->setFile(tempFile);
+
+        SignalFeaturesToUse featuresToUse;
+        featuresToUse.rms = true;
+
+        Array<float> distances;
+        float maxSimilarityDistance = -1;
+        bool finished = engine.calculateSimilarity(segaudioFile, AudioRegion(0, 0.25), segaudioFile, &featuresToUse, nullptr, &distances, &maxSimilarityDistance);
+        expect(finished and distances.size() == 12, "AnalysisEngine number of distances incorrect");
+
+        bool maxIsMax = maxSimilarityDistance >= 0;
+        for(int i=0; i<distances.size(); i++){
+            maxIsMax = maxIsMax and distances[i] <= maxSimilarityDistance;
+        }
+        expect(maxIsMax, "AnalysisEngine max distance incorrect");
+        expect(distances.getLast() == maxSimilarityDistance, "AnalysisEngine loudest block not furthest");
+
+        CancelledEngine cancelledEngine;
+        finished = cancelledEngine.calculateSimilarity(segaudioFile, AudioRegion(0, 0.25), segaudioFile, &featuresToUse, nullptr, &distances, &maxSimilarityDistance);
+        expect(not finished and distances.size() == 0, "AnalysisEngine cancel failed");
+
+        beginTest ("Part 3: AnalysisEngine Silent Blocks");
+
+        // same noise with a silent block in the middle, log(0) and 0/0 mustn't end up in the distances
+        segaudioFile = nullptr;
+        noise.clear(blockSize*5, blockSize);
+        writer = wavFormat.createWriterFor(tempFile.createOutputStream(), 44100, 1, 32, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(noise, 0, noise.getNumSamples());
+        writer = nullptr;
+        segaudioFile = new SegaudioFile();
+        segaudioFile->setFile(tempFile);
+
+        for(int i=0; i<2; i++){
+            SignalFeaturesToUse silentFeatures;
+            silentFeatures.mfcc = (i == 0);
+            silentFeatures.rms = (i == 1);
+            silentFeatures.zcr = (i == 1); // both 0 for silence
+
+            finished = engine.calculateSimilarity(segaudioFile, AudioRegion(0, 0.25), segaudioFile, &silentFeatures, nullptr, &distances, &maxSimilarityDistance);
+            bool allFinite = finished and distances.size() == 12 and juce_isfinite(maxSimilarityDistance);
+            for(int j=0; j<distances.size(); j++){
+                allFinite = allFinite and juce_isfinite(distances[j]);
+            }
+            expect(allFinite, "AnalysisEngine silent block distance not finite");
+        }
+
+        segaudioFile = nullptr; // unmaps tempFile so it can be deleted
+        tempFile.deleteFile();
+    }
+};
+
+
+class BatchSearchTest : public UnitTest
+{
+public:
+    BatchSearchTest()  : UnitTest ("Segaudio Testing") {}
+
+    void runTest()
+    {
+        beginTest ("Part 1: BatchSearch Targets In Parallel");
+
+        File testDirectory = File::getSpecialLocation(File::tempDirectory).getChildFile("SegaudioBatchSearchTest");
+        testDirectory.deleteRecursively();
+        testDirectory.getChildFile("a").createDirectory();
+        testDirectory.getChildFile("b").createDirectory();
+
+        // loud blocks in quiet noise, the same file with the same name in two folders
+        int blockSize = 2048*4;
+        AudioSampleBuffer noise(1, blockSize*16);
+        Random random(50);
+        for(int i=0; i<noise.getNumSamples(); i++){
+            float level = ((i / blockSize) % 4 == 1) ? 1.0f : 0.05f;
+            noise.setSample(0, i, (random.nextFloat() * 2.0f - 1.0f) * level);
+        }
+
+        File referenceFile = testDirectory.getChildFile("reference.wav");
+        File firstTarget = testDirectory.getChildFile("a").getChildFile("target.wav");
+        File secondTarget = testDirectory.getChildFile("b").getChildFile("target.wav");
+
+        WavAudioFormat wavFormat;
+        ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(referenceFile.createOutputStream(), 44100, 1, 16, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(noise, 0, noise.getNumSamples());
+        writer = nullptr; // flushes and closes file
+        referenceFile.copyFileTo(firstTarget);
+        referenceFile.copyFileTo(secondTarget);
+
+        // the same samples compressed, these are decoded instead of memory mapped
+        File flacTarget = testDirectory.getChildFile("b").getChildFile("compressed.flac");
+        FlacAudioFormat flacFormat;
+        writer = flacFormat.createWriterFor(flacTarget.createOutputStream(), 44100, 1, 16, StringPairArray(), 0);
+        writer->writeFromAudioSampleBuffer(noise, 0, noise.getNumSamples());
+        writer = nullptr;
+
+        BatchSearchParameters params;
+        params.referenceFile = referenceFile;
+        params.referenceStartSeconds = double(blockSize) / 44100;
+        params.referenceEndSeconds = double(blockSize*2) / 44100; // one loud block
+        params.featuresToUse.rms = true;
+        params.clusterParams.threshold = 0.5;
+        params.clusterParams.regionConnectionWidth = 0;
+        params.outputDirectory = testDirectory.getChildFile("out");
+
+        BatchSearch search(params);
+        search.addTargetsInDirectory(testDirectory.getChildFile("a"), false);
+        search.addTarget(secondTarget);
+        search.addTarget(flacTarget);
+        search.addTarget(testDirectory.getChildFile("missing.wav"));
+
+        expect(search.getNumTargets() == 4, "BatchSearch number of targets incorrect");
+        expect(search.run(2), "BatchSearch reference not read");
+        expect(search.getNumSucceeded() == 3 and search.getNumFailed() == 1, "BatchSearch results incorrect");
+
+        bool sameRegions = true;
+        for(int i=0; i<search.getNumTargets(); i++){
+            const TargetSearchResult &result = search.getResult(i);
+            if(result.succeeded){
+                sameRegions = sameRegions and result.numRegions == search.getResult(0).numRegions and result.boundaryFile.existsAsFile();
+            }
+        }
+        expect(search.getResult(0).numRegions > 0 and sameRegions, "BatchSearch regions incorrect");
+        expect(search.getResult(2).succeeded and search.getResult(2).numRegions == search.getResult(0).numRegions, "BatchSearch compressed target not decoded");
+        expect(params.outputDirectory.getChildFile("target.csv").existsAsFile() and params.outputDirectory.getChildFile("target_2.csv").existsAsFile(), "BatchSearch output names clash");
+
+        beginTest ("Part 2: BatchSearch Bad Reference");
+        params.referenceFile = testDirectory.getChildFile("missing.wav");
+        BatchSearch badSearch(params);
+        badSearch.addTarget(firstTarget);
+        expect(not badSearch.run(1) and badSearch.getErrorMessage().isNotEmpty(), "BatchSearch bad reference not reported");
+
+        testDirectory.deleteRecursively();
+    }
+};
+
+
 class SignalFeaturesToUseTest : public UnitTest
 {
 public:
@@ -142,6 +994,22 @@ public:
 
 static SignalFeaturesToUseTest signalFeaturesToUseTest;
 static AudioRegionTest audioRegionTest;
+static AudioRegionIndexTest audioRegionIndexTest;
+static DistanceStatisticsTest distanceStatisticsTest;
+static OnlineRegionSegmenterTest onlineRegionSegmenterTest;
+static SegaudioFileTest segaudioFileTest;
+static FileFingerprintTest fileFingerprintTest;
+static WavRegionCopierTest wavRegionCopierTest;
+static RegionExporterTest regionExporterTest;
+static RegionBoundaryWriterTest regionBoundaryWriterTest;
+static ExportQueueTest exportQueueTest;
+static BatchExportPlanTest batchExportPlanTest;
+static RegionRendererTest regionRendererTest;
+static CompactSampleBufferTest compactSampleBufferTest;
+static SampleBlockCacheTest sampleBlockCacheTest;
+static SegaudioModelTest segaudioModelTest;
+static AnalysisEngineTest analysisEngineTest;
+static BatchSearchTest batchSearchTest;
 
 
 